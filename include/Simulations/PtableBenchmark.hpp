@@ -0,0 +1,41 @@
+#ifndef PTABLEBENCHMARK_HPP
+#define PTABLEBENCHMARK_HPP
+
+#include "ns3/core-module.h"
+#include "gpsr/gpsr-ptable.h"
+#include <vector>
+
+/**
+ * PtableBenchmark class
+ * Times GpsrPtable::BestNeighbor and GpsrPtable::IsNeighbor on the map and
+ * the flat backend for a range of neighbor counts, outside of any
+ * simulation. Both backends get the same neighbors and queries, and the
+ * answers are checked to agree.
+ */
+class PtableBenchmark {
+public:
+    /**
+     * Constructor
+     * @param sizes Neighbor counts to time
+     * @param seed Seed of the neighbor positions and queries
+     */
+    explicit PtableBenchmark(const std::vector<uint32_t> &sizes = {8, 64, 512, 4096}, uint32_t seed = 1);
+
+    /**
+     * Time every backend at every size and print one line each
+     * @return False if the backends disagreed on any query
+     */
+    bool Run();
+
+private:
+    /**
+     * Time one backend at one size, adding the answers to checksum
+     * @return Mean nanoseconds per BestNeighbor and per IsNeighbor call
+     */
+    std::pair<double, double> Measure(ns3::GpsrPtable::Backend backend, uint32_t size, uint64_t &checksum);
+
+    std::vector<uint32_t> m_sizes;  // Neighbor counts to time
+    uint32_t m_seed;                // Seed of positions and queries
+};
+
+#endif // PTABLEBENCHMARK_HPP
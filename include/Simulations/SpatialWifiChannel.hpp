@@ -0,0 +1,123 @@
+#ifndef SPATIALWIFICHANNEL_HPP
+#define SPATIALWIFICHANNEL_HPP
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/propagation-module.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * SpatialWifiChannel class
+ * Limits the receivers of every frame to the PHYs within a cutoff distance
+ * of the sender. A YansWifiChannel schedules a reception at every other
+ * PHY, O(N) events per frame, even though Yans drops the ones below the
+ * receive sensitivity on arrival.
+ *
+ * YansWifiChannel::Send is not virtual, so each PHY is given a channel of
+ * its own that holds only the PHYs near it, found through a uniform grid
+ * of cutoff-sized cells. Receptions are unchanged as long as the cutoff is
+ * at or beyond the distance where frames fall below the sensitivity, which
+ * is what a cutoff of 0 derives from the loss model.
+ *
+ * PHYs that come within the cutoff are added to a channel in place. A
+ * channel cannot drop a PHY, and every new channel stays in the global
+ * ChannelList until Simulator::Destroy, so PHYs that left the cutoff stay
+ * on it until they outnumber the ones in range. Only then is the channel
+ * replaced. Stale receivers get the frames Yans would have given them,
+ * and the number of channels created stays proportional to the movement
+ * instead of to the number of updates.
+ *
+ * A node's receivers are updated when its mobility model reports a course
+ * change. Nodes also drift between course changes, so moving topologies
+ * need a refresh interval that updates every channel periodically and a
+ * margin of at least the distance two nodes can close in that interval.
+ */
+class SpatialWifiChannel {
+public:
+    /**
+     * Constructor, moves the devices onto their own channels
+     * @param devices WiFi devices on one YansWifiChannel, their nodes with a mobility model
+     * @param cutoff Distance in metres beyond which no reception is scheduled,
+     *               0 for the distance where frames fall below the receive sensitivity
+     * @param refresh Period at which all channels are updated, 0 for course changes only
+     * @param margin Distance in metres added to the cutoff to cover drift between refreshes
+     */
+    SpatialWifiChannel(const ns3::NetDeviceContainer &devices, double cutoff,
+                       ns3::Time refresh = ns3::Seconds(0), double margin = 0.0);
+
+    /**
+     * Get the cutoff distance in use, in metres, margin included
+     */
+    double GetCutoff() const;
+
+    /**
+     * Get the mean number of receivers per sender
+     */
+    double GetMeanReceivers() const;
+
+    /**
+     * Get the number of channels created, one per PHY at start-up plus
+     * the replacements
+     */
+    uint64_t GetChannelCount() const;
+
+private:
+    /**
+     * Distance in metres where a frame from phy falls below the receive sensitivity
+     */
+    double SensitivityRange(ns3::Ptr<ns3::YansWifiPhy> phy) const;
+
+    /**
+     * Grid cell holding a position
+     */
+    uint64_t CellOf(const ns3::Vector &position) const;
+
+    /**
+     * Indices of the PHYs within the cutoff of a position, from the grid
+     */
+    std::vector<uint32_t> Nearby(const ns3::Vector &position) const;
+
+    /**
+     * Give PHY i a new channel with the given PHYs
+     */
+    void Rebuild(uint32_t i, const std::vector<uint32_t> &nearby);
+
+    /**
+     * Add the PHYs that came within the cutoff of PHY i to its channel,
+     * and replace the channel once most of its receivers are out of range
+     */
+    void Update(uint32_t i);
+
+    /**
+     * Re-index every PHY in the grid
+     */
+    void Index();
+
+    /**
+     * Update all channels and schedule the next refresh
+     */
+    void Refresh();
+
+    /**
+     * Follow a course change of node i
+     */
+    void CourseChanged(uint32_t i, ns3::Ptr<const ns3::MobilityModel> mobility);
+
+    double m_cutoff;                                              // Reception cutoff in metres
+    ns3::Time m_refresh;                                          // Period of Refresh, 0 for none
+    uint64_t m_channelCount;                                      // Channels created so far
+    ns3::Ptr<ns3::PropagationLossModel> m_loss;                   // Loss model of the original channel
+    ns3::Ptr<ns3::PropagationDelayModel> m_delay;                 // Delay model of the original channel
+    std::vector<ns3::Ptr<ns3::YansWifiPhy>> m_phys;               // PHYs by index
+    std::vector<ns3::Ptr<ns3::MobilityModel>> m_mobility;         // Their mobility models
+    std::vector<ns3::Ptr<ns3::YansWifiChannel>> m_channels;       // Channel each PHY sends on
+    std::vector<std::unordered_set<uint32_t>> m_receivers;        // PHYs on each channel
+    std::vector<uint64_t> m_cellOf;                               // Grid cell of each PHY
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;  // PHYs by grid cell
+};
+
+#endif // SPATIALWIFICHANNEL_HPP
@@ -6,7 +6,10 @@
 #include "ns3/mobility-module.h"
 #include "ns3/internet-module.h"
 #include <iostream>
+#include <map>
+#include <memory>
 #include "AbstractSimulation.hpp"
+#include "SpatialWifiChannel.hpp"
 
 /**
  * StaticSimulationGPSR class
@@ -21,8 +24,23 @@ public:
      * Constructor
      * @param numNodes Number of nodes in the simulation
      * @param simulationTime Duration of the simulation in seconds
+     * @param packetSize Payload size of the echo client packets in bytes
+     * @param topology Node placement, "Grid", "Void" (grid with a hole) or "Random"
+     * @param mobility Node movement, "Static" or "RandomWaypoint"
+     * @param speed Random waypoint speed in m/s
+     * @param flows Number of concurrent echo flows, node i to node numNodes - 1 - i
+     * @param flowInterval Time between the packets of each flow in seconds
+     * @param oracleRange Fill the neighbor tables of static nodes within this range
+     *                    from their true positions, 0 to discover neighbors by HELLOs
+     * @param channel WiFi channel, "Yans" (every PHY hears every frame) or "Spatial"
+     * @param channelCutoff Spatial channel reception cutoff in metres, 0 for the
+     *                      distance where frames fall below the receive sensitivity
      */
-    StaticSimulationGPSR(const int numNodes, const double simulationTime);
+    StaticSimulationGPSR(const int numNodes, const double simulationTime, const uint32_t packetSize = 512,
+                         const std::string &topology = "Grid", const std::string &mobility = "Static",
+                         const double speed = 5.0, const uint32_t flows = 1, const double flowInterval = 1.0,
+                         const double oracleRange = 0.0, const std::string &channel = "Yans",
+                         const double channelCutoff = 0.0);
 
     /**
      * Destructor
@@ -41,7 +59,7 @@ protected:
     void SetupRoutingProtocol() override;
 
     /**
-     * Set up applications (Echo server/client)
+     * Set up applications (one echo server/client pair per flow)
      */
     void ConfigureApplications() override;
 
@@ -66,6 +84,34 @@ private:
   * Print the routing tables for all nodes
   */
  void PrintRoutingTables();
+
+ /**
+  * Print the median and tail end-to-end delay over all flows
+  * @param delayBins Packets per delay histogram bin, keyed by bin start
+  */
+ void PrintDelayPercentiles(const std::map<double, uint32_t> &delayBins);
+
+ /**
+  * Print the per-packet GPSR header bytes and forwarding cost summed over all nodes
+  */
+ void PrintForwardingStats();
+
+ /**
+  * Print the HELLO beacon overhead summed over all nodes
+  */
+ void PrintControlStats();
+
+ uint32_t m_packetSize; // Echo payload size in bytes
+ std::string m_mobility; // Node movement model
+ double m_speed;         // Random waypoint speed in m/s
+ uint32_t m_flows;       // Concurrent echo flows
+ double m_flowInterval;  // Time between the packets of each flow in seconds
+ double m_wallTime;      // Wall-clock seconds spent in Simulator::Run
+ double m_oracleRange;   // Neighbor oracle range in metres, 0 when HELLOs discover neighbors
+ uint64_t m_oracleEntries; // Neighbor entries the oracle added
+ std::string m_channel;  // WiFi channel, "Yans" or "Spatial"
+ double m_channelCutoff; // Spatial channel cutoff in metres, 0 for the sensitivity range
+ std::unique_ptr<SpatialWifiChannel> m_spatialChannel; // Set up with the topology for "Spatial"
 };
 
 #endif // STATICSIMULATIONGPSR_HPP
\ No newline at end of file
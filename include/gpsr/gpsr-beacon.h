@@ -0,0 +1,82 @@
+#ifndef GPSR_BEACON_H
+#define GPSR_BEACON_H
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ *  Calendar of HELLO beacons shared by all GPSR instances of a simulation
+ *
+ * Beacon times are rounded up to a slot and kept in one calendar, and a
+ * single simulator event per non-empty slot dispatches every beacon due
+ * in it, instead of one event per node and beacon. Cancelling a beacon
+ * only searches its own slot, which holds few beacons for slots much
+ * shorter than the HELLO interval.
+ *
+ * Beacons run in the context of the slot event rather than of their node,
+ * which only shows in log prefixes; packets sent reach the channel with
+ * the receivers' contexts as usual.
+ *
+ * Use SimulationSingleton<GpsrBeaconScheduler>::Get(), which resets the
+ * calendar on Simulator::Destroy.
+ */
+class GpsrBeaconScheduler
+{
+public:
+  GpsrBeaconScheduler();
+  ~GpsrBeaconScheduler();
+
+  /**
+   *  Schedules a beacon
+   *  delay Time from now until the beacon is due
+   *  slot Slot width the due time is rounded up to, must be positive
+   *  beacon Called when the slot comes up
+   *  An id for Cancel and IsPending, never 0
+   */
+  uint64_t Schedule(Time delay, Time slot, Callback<void> beacon);
+
+  /**
+   *  Cancels a beacon, ids of beacons already run or cancelled are ignored
+   */
+  void Cancel(uint64_t id);
+
+  /**
+   *  True if the beacon with this id has neither run nor been cancelled
+   */
+  bool IsPending(uint64_t id) const;
+
+  // Slot events run and beacons dispatched by them
+  uint64_t GetSlotEventCount() const;
+  uint64_t GetDispatchCount() const;
+
+private:
+  // Runs the beacons of the earliest slot and schedules the next one
+  void RunSlot();
+
+  // Moves the slot event to the earliest slot in the calendar
+  void ScheduleSlot();
+
+  struct Beacon
+  {
+    int64_t due;            // Due time in simulator time steps
+    Callback<void> beacon;
+  };
+
+  std::map<int64_t, std::vector<uint64_t>> m_calendar; // Beacon ids by due time in time steps
+  std::unordered_map<uint64_t, Beacon> m_beacons;      // Pending beacons by id
+  EventId m_slotEvent;                                 // Runs the earliest slot
+  int64_t m_slotEventDue;                              // Time steps m_slotEvent runs at
+  uint64_t m_nextId;
+  uint64_t m_slotEvents;
+  uint64_t m_dispatched;
+};
+
+} // namespace ns3
+
+#endif // GPSR_BEACON_H
@@ -0,0 +1,61 @@
+#ifndef GPSR_GREEDY_KERNEL_H
+#define GPSR_GREEDY_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ns3 {
+
+/**
+ *  Vectorized greedy next-hop search over packed coordinates
+ *
+ * Works on the structure-of-arrays layout of GpsrPtable (FLAT_BACKEND) and
+ * returns the same neighbor the scalar CalculateDistance loop would: the
+ * first index, in array order, with the smallest Euclidean distance to the
+ * destination. Squared distances are compared, and a second pass recovers
+ * the first index whose distance rounds to the same sqrt as the minimum, so
+ * ties are broken exactly like the original strict '>' comparison.
+ *
+ * AVX2 and SSE2 paths are chosen at runtime, with a scalar fallback on
+ * other targets.
+ */
+class GpsrGreedyKernel
+{
+public:
+  /**
+   *  Instruction set used by the kernel
+   */
+  enum Isa
+  {
+    SCALAR = 0,
+    SSE2 = 1,
+    AVX2 = 2,
+  };
+
+  /**
+   *  Finds the neighbor closest to a destination
+   *  xs, ys Packed neighbor coordinates (neighbors have z = 0)
+   *  n Number of neighbors, must be > 0
+   *  dst Destination position x, y, z
+   *  distance Set to the distance from the selected neighbor to dst
+   *  The index of the selected neighbor
+   */
+  static std::size_t ArgMin(const double *xs, const double *ys, std::size_t n,
+                            double dstX, double dstY, double dstZ, double &distance);
+
+  /**
+   *  Same as ArgMin, forcing a given instruction set (falls back to the
+   *  best supported one below it)
+   */
+  static std::size_t ArgMin(Isa isa, const double *xs, const double *ys, std::size_t n,
+                            double dstX, double dstY, double dstZ, double &distance);
+
+  /**
+   *  Best instruction set supported by the running CPU
+   */
+  static Isa GetIsa();
+};
+
+} // namespace ns3
+
+#endif // GPSR_GREEDY_KERNEL_H
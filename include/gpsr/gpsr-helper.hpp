@@ -5,6 +5,7 @@
 #include "ns3/node.h"
 #include "ns3/node-container.h"
 #include "ns3/ipv4-routing-helper.h"
+#include "ns3/propagation-loss-model.h"
 
 namespace ns3 {
 
@@ -44,6 +45,27 @@ namespace ns3 {
          */
         void Install() const;
 
+        /**
+         * \brief Fill the GPSR neighbor tables of static nodes from their true positions
+         *
+         * Nodes are bucketed into a grid of range-sized cells, so each node
+         * is only compared with the nodes of its own and the eight
+         * surrounding cells, O(N) for an even node density. Entries are
+         * added with Gpsr::AddStaticNeighbor and never expire, so HELLOs
+         * can be turned off (HelloMode Off) or sent rarely as keepalives.
+         * Call it after IPv4 addresses are assigned.
+         *
+         * \param nodes Nodes with GPSR, a mobility model and an address on interface 1
+         * \param range Nodes at most this far apart are neighbors
+         * \param loss If set, neighbors must also receive each other at rxThreshold or above
+         * \param txPower Transmit power in dBm given to loss
+         * \param rxThreshold Lowest receive power in dBm that makes a link
+         * \return Number of neighbor entries added over all nodes
+         */
+        static uint64_t PopulateNeighbors(NodeContainer nodes, double range,
+                                          Ptr<PropagationLossModel> loss = nullptr,
+                                          double txPower = 0.0, double rxThreshold = 0.0);
+
     private:
         ObjectFactory m_agentFactory; //!< Object factory to create GPSR instances
     };
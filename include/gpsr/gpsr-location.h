@@ -0,0 +1,74 @@
+#ifndef GPSR_LOCATION_H
+#define GPSR_LOCATION_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ *  Destination position service used by GPSR
+ *
+ * Maps every address owned by a GPSR node to the mobility model of that
+ * node, so the destination position of a packet can be resolved in O(1)
+ * instead of walking every node, interface and address in the NodeList.
+ * The table is shared by all Gpsr instances of a simulation and is kept
+ * up to date from Gpsr::NotifyAddAddress / Gpsr::NotifyRemoveAddress.
+ */
+class GpsrLocationService
+{
+public:
+  /**
+   *  Registers an address as belonging to a node
+   *  addr The IPv4 address
+   *  node The node owning the address
+   */
+  static void AddAddress(Ipv4Address addr, Ptr<Node> node);
+
+  /**
+   *  Removes an address from the service
+   *  addr The IPv4 address
+   */
+  static void RemoveAddress(Ipv4Address addr);
+
+  /**
+   *  Gets the mobility model of the node owning an address
+   *  addr The IPv4 address
+   *  The mobility model, or null if unknown
+   */
+  static Ptr<MobilityModel> GetMobilityModel(Ipv4Address addr);
+
+  /**
+   *  Gets the current position of the node owning an address
+   *  addr The IPv4 address
+   *  position Set to the position when found
+   *  True if the position is known, false otherwise
+   */
+  static bool GetPosition(Ipv4Address addr, Vector &position);
+
+  /**
+   *  Number of registered addresses
+   */
+  static uint32_t GetSize();
+
+  /**
+   *  Removes all entries
+   */
+  static void Clear();
+
+private:
+  struct Entry
+  {
+    Ptr<Node> node;               // Node owning the address
+    Ptr<MobilityModel> mobility;  // Cached mobility model, resolved lazily
+  };
+
+  static std::unordered_map<uint32_t, Entry> &GetTable();
+};
+
+} // namespace ns3
+
+#endif // GPSR_LOCATION_H
@@ -7,6 +7,7 @@
 
 #include "ns3/header.h"
 #include "ns3/enum.h"
+#include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/nstime.h"
 #include "ns3/vector.h"
@@ -22,6 +23,34 @@ enum GpsrMessageType
   GPSR_POSITION = 1,    // Position message
 };
 
+/**
+ *  Wire encoding of the Hello and Position headers
+ *
+ * Selected for the whole simulation with the "GpsrHeaderFormat" global
+ * value, since every node has to parse what the others send.
+ *
+ * GPSR_FORMAT_RAW sends host-endian doubles for every field; the Position
+ * header keeps its original dst, recovery, previous hop, updated and flag
+ * layout and appends the face and first edge coordinates and the perimeter
+ * hop count only when the recovery flag is set.
+ * GPSR_FORMAT_COMPACT starts with a version/flags byte and sends
+ * coordinates as 32-bit fixed point (millimetres) in network byte order;
+ * the Position header leaves out the recovery, previous hop, face and
+ * first edge coordinates and the perimeter hop count unless the recovery
+ * flag is set.
+ */
+enum GpsrHeaderFormat
+{
+  GPSR_FORMAT_RAW = 0,
+  GPSR_FORMAT_COMPACT = 1,
+};
+
+/**
+ *  Get the header format selected by the "GpsrHeaderFormat" global value
+ *  The header format
+ */
+GpsrHeaderFormat GetGpsrHeaderFormat();
+
 /**
  *  GPSR message type header
  */
@@ -79,7 +108,12 @@ std::ostream & operator<<(std::ostream & os, GpsrTypeHeader const & h);
 /**
  *  GPSR Hello header
  *
- * Contains position information for neighbor discovery
+ * Contains position information for neighbor discovery, and optionally
+ * the sender's velocity and the time the position was sampled so that
+ * receivers can extrapolate it, and the sender's load. Both are flagged
+ * in the version/flags byte in the compact format. The raw format keeps
+ * its 16 bytes of coordinates when neither is sent and otherwise ends
+ * with a flags byte, so it has to be the last header in the packet.
  */
 class GpsrHelloHeader : public Header
 {
@@ -128,6 +162,35 @@ public:
    */
   double GetPositionY() const;
 
+  /**
+   *  Attach the sender's motion
+   *  vx, vy Velocity in m/s
+   *  timestamp When the position was sampled
+   */
+  void SetMotion(double vx, double vy, Time timestamp);
+
+  /**
+   *  True if the header carries velocity and timestamp
+   */
+  bool HasMotion() const;
+
+  double GetVelocityX() const;
+  double GetVelocityY() const;
+  Time GetTimestamp() const;
+
+  /**
+   *  Attach the sender's load
+   *  load Occupancy of its transmit queue in [0, 1], sent in 1/255 steps
+   */
+  void SetLoad(double load);
+
+  /**
+   *  True if the header carries the sender's load
+   */
+  bool HasLoad() const;
+
+  double GetLoad() const;
+
   /**
    *  Comparison operator
    *  o The header to compare with
@@ -136,8 +199,15 @@ public:
   bool operator==(GpsrHelloHeader const & o) const;
 
 private:
+  GpsrHeaderFormat m_format; // Wire encoding, from GetGpsrHeaderFormat()
   double m_positionX;
   double m_positionY;
+  bool m_hasMotion;          // Velocity and timestamp follow the position
+  double m_velocityX;
+  double m_velocityY;
+  Time m_timestamp;
+  bool m_hasLoad;            // Load follows the position and motion
+  uint8_t m_load;            // Load in 1/255 steps
 };
 
 /**
@@ -161,7 +231,8 @@ public:
    */
   GpsrPositionHeader(double dstX = 0.0, double dstY = 0.0, uint32_t updated = 0,
                    double recX = 0.0, double recY = 0.0, bool recoveryFlag = false,
-                   double prevX = 0.0, double prevY = 0.0);
+                   double prevX = 0.0, double prevY = 0.0,
+                   double faceX = 0.0, double faceY = 0.0);
 
   /**
    *  Get the type ID
@@ -203,6 +274,35 @@ public:
   void SetPrevPositionY(double y);
   double GetPrevPositionY() const;
 
+  // Point where the packet entered the current face (Lf)
+  void SetFacePositionX(double x);
+  double GetFacePositionX() const;
+
+  void SetFacePositionY(double y);
+  double GetFacePositionY() const;
+
+  // First edge traversed on the current face (e0), from and to positions.
+  // Equal ends mean no edge has been recorded yet.
+  void SetFirstEdge(Vector from, Vector to);
+  Vector GetFirstEdgeFrom() const;
+  Vector GetFirstEdgeTo() const;
+
+  // Perimeter hops since the packet entered recovery
+  void SetPerimeterHops(uint16_t hops);
+  uint16_t GetPerimeterHops() const;
+
+  /**
+   *  Serialized size of the position header at the start of a packet
+   *
+   * Reads at most up to the flags byte, the first byte in the compact
+   * format and the one after the fixed fields in the raw one, so a header
+   * can be replaced with RemoveAtStart instead of being deserialized just
+   * to learn its length.
+   *  p Packet starting with a position header
+   *  The header size in bytes
+   */
+  static uint32_t PeekSerializedSize(Ptr<const Packet> p);
+
   /**
    *  Comparison operator
    *  o The header to compare with
@@ -211,6 +311,7 @@ public:
   bool operator==(GpsrPositionHeader const & o) const;
 
 private:
+  GpsrHeaderFormat m_format; // Wire encoding, from GetGpsrHeaderFormat()
   // Using double for coordinates
   double m_dstPositionX;   // Destination X coordinate
   double m_dstPositionY;   // Destination Y coordinate
@@ -221,6 +322,13 @@ private:
   // Renamed from m_lastPositionX/Y
   double m_prevPositionX;  // Previous hop X coordinate in recovery
   double m_prevPositionY;  // Previous hop Y coordinate in recovery
+  double m_facePositionX;  // X coordinate where the current face was entered
+  double m_facePositionY;  // Y coordinate where the current face was entered
+  double m_edgeFromX;      // First edge on the current face, sending end
+  double m_edgeFromY;
+  double m_edgeToX;        // First edge on the current face, receiving end
+  double m_edgeToY;
+  uint16_t m_perimeterHops; // Perimeter hops since recovery started
 };
 
 /**
@@ -228,6 +336,60 @@ private:
  */
 std::ostream & operator<<(std::ostream & os, GpsrPositionHeader const & h);
 
+/**
+ *  GPSR Sender header
+ *
+ * Hop-by-hop field a data frame carries in front of everything else in
+ * its IP payload: the address and position of the node that transmitted
+ * it. Every node that hears the frame refreshes its neighbor table from
+ * it, so forwarded data doubles as a HELLO.
+ */
+class GpsrSenderHeader : public Header
+{
+public:
+  /**
+   *  Constructor
+   *  sender Address of the transmitting node
+   *  x, y Its position
+   */
+  GpsrSenderHeader(Ipv4Address sender = Ipv4Address(), double x = 0.0, double y = 0.0);
+
+  /**
+   *  Get the type ID
+   *  The object TypeId
+   */
+  static TypeId GetTypeId();
+  TypeId GetInstanceTypeId() const;
+
+  // Header serialization
+  uint32_t GetSerializedSize() const;
+  void Serialize(Buffer::Iterator start) const;
+  uint32_t Deserialize(Buffer::Iterator start);
+  void Print(std::ostream &os) const;
+
+  Ipv4Address GetSender() const;
+  double GetPositionX() const;
+  double GetPositionY() const;
+
+  /**
+   *  Comparison operator
+   *  o The header to compare with
+   *  True if equal, false otherwise
+   */
+  bool operator==(GpsrSenderHeader const & o) const;
+
+private:
+  GpsrHeaderFormat m_format; // Wire encoding, from GetGpsrHeaderFormat()
+  Ipv4Address m_sender;
+  double m_positionX;
+  double m_positionY;
+};
+
+/**
+ *  Stream insertion operator
+ */
+std::ostream & operator<<(std::ostream & os, GpsrSenderHeader const & h);
+
 } // namespace ns3
 
 #endif // GPSR_PACKET_H
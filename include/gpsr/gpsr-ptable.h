@@ -10,7 +10,13 @@
 #include "ns3/mobility-model.h"
 #include "ns3/wifi-mac-header.h"
 #include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+#include <functional>
 #include <map>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace ns3 {
 
@@ -29,8 +35,156 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /**
+   *  Storage layouts for the neighbor entries
+   */
+  enum Backend
+  {
+    MAP_BACKEND = 0,   // std::map keyed by address (original layout)
+    FLAT_BACKEND = 1,  // Contiguous arrays of addresses, coordinates and ticks
+  };
+
+  /**
+   *  Planar subgraphs the perimeter mode can run on
+   */
+  enum Planarization
+  {
+    PLANAR_NONE = 0,  // Right-hand rule over the full neighbor set
+    PLANAR_GG = 1,    // Gabriel graph
+    PLANAR_RNG = 2,   // Relative neighborhood graph
+  };
+
+  /**
+   *  Greedy forwarding metrics
+   */
+  enum Metric
+  {
+    METRIC_DISTANCE = 0,      // Neighbor closest to the destination
+    METRIC_PRR_DISTANCE = 1,  // Largest reception ratio x progress
+    METRIC_ETX_PROGRESS = 2,  // Smallest expected transmissions per metre of progress
+  };
+
   GpsrPtable();
 
+  /**
+   *  Selects the storage layout, migrating any existing entries
+   *  backend The layout to use
+   */
+  void SetBackend(Backend backend);
+
+  /**
+   *  Gets the storage layout in use
+   */
+  Backend GetBackend() const;
+
+  /**
+   *  Selects the planar subgraph used by BestAngle
+   *  planarization The subgraph to use
+   */
+  void SetPlanarization(Planarization planarization);
+
+  /**
+   *  Gets the planar subgraph used by BestAngle
+   */
+  Planarization GetPlanarization() const;
+
+  /**
+   *  Enables position prediction for neighbors that advertise their motion
+   *
+   * Their positions are extrapolated to Simulator::Now() on every lookup,
+   * and they are expired once predicted out of radio range of the lookup
+   * position or after the predicted lifetime, instead of after the entry
+   * lifetime.
+   */
+  void SetPrediction(bool prediction);
+  bool GetPrediction() const;
+
+  /**
+   *  Distance beyond which a predicted neighbor is out of range, 0 disables
+   *  the range check
+   */
+  void SetRadioRange(double range);
+  double GetRadioRange() const;
+
+  /**
+   *  Lifetime of entries whose position is predicted
+   */
+  void SetPredictedLifetime(Time lifetime);
+  Time GetPredictedLifetime() const;
+
+  /**
+   *  Selects the metric BestNeighbor ranks neighbors by
+   */
+  void SetMetric(Metric metric);
+  Metric GetMetric() const;
+
+  /**
+   *  Records a frame heard from a neighbor
+   *  id The IPv4 address of the neighbor
+   *  expectedInterval Longest gap between its HELLOs when none is lost
+   *
+   * Every expected HELLO missing from the gap since the last frame counts
+   * as a loss in the neighbor's reception ratio.
+   */
+  void NotifyReception(Ipv4Address id, Time expectedInterval);
+
+  /**
+   *  Records the SNR of a broadcast frame heard from a neighbor
+   *  id The IPv4 address of the neighbor
+   *  snr The signal to noise ratio in dB
+   */
+  void NotifySnr(Ipv4Address id, double snr);
+
+  /**
+   *  Records the outcome of one MAC transmission attempt to a neighbor
+   *  id The IPv4 address of the neighbor
+   *  success True if the attempt was acknowledged
+   */
+  void NotifyTxAttempt(Ipv4Address id, bool success);
+
+  /**
+   *  Estimated probability that a frame to a neighbor gets through, in [0, 1]
+   *
+   * The HELLO reception ratio scaled down on links with a poor SNR. Under
+   * METRIC_ETX_PROGRESS the acknowledged fraction of unicast attempts is
+   * used instead once there is any.
+   */
+  double GetLinkQuality(Ipv4Address id) const;
+
+  /**
+   *  Spreads greedy traffic over the neighbors whose score is within this
+   *  fraction of the best one, 0 always picks the best
+   */
+  void SetLoadTolerance(double tolerance);
+  double GetLoadTolerance() const;
+
+  /**
+   *  Stream of the variable spreading draws the next hop from, created on
+   *  the first draw
+   */
+  void SetSpreadStream(int64_t stream);
+
+  /**
+   *  Records the load a neighbor advertised, in [0, 1]
+   */
+  void SetNeighborLoad(Ipv4Address id, double load);
+
+  /**
+   *  Last load a neighbor advertised, 0 if it never did
+   */
+  double GetNeighborLoad(Ipv4Address id) const;
+
+  /**
+   *  Number of neighbors currently stored (including not yet purged ones)
+   */
+  uint32_t GetSize() const;
+
+  /**
+   *  Counter bumped whenever a neighbor is added, moves, is deleted or
+   *  expires, so cached forwarding decisions can tell they are stale
+   */
+  uint64_t GetEpoch() const;
+
   /**
    *  Gets the time when an entry was last updated
    *  id The IPv4 address of the node
@@ -45,6 +199,28 @@ public:
    */
   void AddEntry(Ipv4Address id, Vector position);
 
+  /**
+   *  Adds an entry together with the neighbor's motion
+   *  id The IPv4 address of the node
+   *  position The position of the node at timestamp
+   *  velocity The velocity of the node
+   *  timestamp When position was sampled
+   *
+   * Without prediction enabled the motion is ignored.
+   */
+  void AddEntry(Ipv4Address id, Vector position, Vector velocity, Time timestamp);
+
+  /**
+   *  Adds an entry that never expires, for neighbors known from the true
+   *  topology rather than from HELLOs
+   *  id The IPv4 address of the node
+   *  position The position of the node
+   *
+   * The entry stays until DeleteEntry or Clear. HELLOs from the neighbor
+   * update its position but do not make it expire again.
+   */
+  void AddStaticEntry(Ipv4Address id, Vector position);
+
   /**
    *  Deletes an entry from the position table
    *  id The IPv4 address of the node to delete
@@ -67,6 +243,10 @@ public:
 
   /**
    *  Removes entries with expired lifetime
+   *
+   * Only the entries that are actually due are visited, by popping the
+   * expiry heap, so the cost is O(log n) per expired entry rather than a
+   * full table scan per call.
    */
   void Purge();
 
@@ -80,6 +260,12 @@ public:
    *  position The position of the destination
    *  nodePos The position of the current node
    *  The IP address of the best next hop, or zero if none found
+   *
+   * Under the link quality metrics only neighbors that make progress are
+   * candidates, so greedy forwarding still cannot loop. With a load
+   * tolerance set, the next hop is drawn at random among the neighbors
+   * within the tolerance of the best score, weighted by score times the
+   * capacity they have left.
    */
   Ipv4Address BestNeighbor(Vector position, Vector nodePos);
 
@@ -88,6 +274,12 @@ public:
    *  prevHop The position of the previous hop
    *  nodePos The position of the current node
    *  The IP address of the best next hop
+   *
+   * Neighbors are kept in a ring sorted by bearing around myPos, so the
+   * counter-clockwise successor of the previous hop is a binary search.
+   * The ring is only re-sorted when a neighbor is added, moved or removed,
+   * or when myPos changes. With a planarization selected, only neighbors
+   * that keep their edge in the planar subgraph are part of the ring.
    */
   Ipv4Address BestAngle(Vector dstPos, Vector recPos, Vector myPos, Vector prevPos);
 
@@ -100,6 +292,20 @@ public:
    */
   double GetAngle(Vector center, Vector refPos, Vector node);
 
+  /**
+   *  Monotonic stand-in for the bearing of a vector, in [0, 4)
+   *  dx, dy The vector components
+   *  0 on the positive x axis, increasing counter-clockwise
+   */
+  static double PseudoAngle(double dx, double dy);
+
+  /**
+   *  Intersection of segments a1-a2 and b1-b2
+   *  cross Set to the intersection point when found
+   *  True if the segments intersect in a single point
+   */
+  static bool SegmentIntersection(Vector a1, Vector a2, Vector b1, Vector b2, Vector &cross);
+
   /**
    *  Returns an invalid position vector
    *  Vector(-1, -1, 0)
@@ -107,8 +313,189 @@ public:
   static Vector GetInvalidPosition();
 
 private:
+  /**
+   *  Stores an entry with an explicit update time
+   */
+  void InsertEntry(Ipv4Address id, Vector position, Time updated);
+
+  /**
+   *  Index of an address in the flat arrays, or -1 if absent
+   */
+  int32_t FindFlat(Ipv4Address id) const;
+
+  /**
+   *  Calls f(address, position) for every entry in ascending address order
+   */
+  template <typename F>
+  void ForEachEntry(F f) const;
+
+  /**
+   *  Rebuilds the expiry heap from the live entries, dropping stale records
+   */
+  void RebuildExpiry();
+
+  /**
+   *  Lifetime of an entry, depending on whether it is static or its
+   *  position is predicted
+   */
+  int64_t GetLifetime(uint32_t id) const;
+
+  /**
+   *  Reads the stored position of an entry without purging, false if absent
+   */
+  bool GetEntryPosition(Ipv4Address id, Vector &position) const;
+
+  /**
+   *  Moves an entry without refreshing it
+   */
+  void SetEntryPosition(Ipv4Address id, Vector position);
+
+  /**
+   *  Extrapolates the predicted entries to now, in time steps
+   */
+  void Advance(int64_t now);
+
+  /**
+   *  Deletes predicted entries that are out of range of nodePos
+   */
+  void ExpireOutOfRange(const Vector &nodePos);
+
+  /**
+   *  Best neighbor under a link quality metric, or zero if none makes progress
+   */
+  Ipv4Address BestLinkNeighbor(const Vector &position, const Vector &nodePos) const;
+
+  /**
+   *  Next hop drawn among the near-best neighbors, or zero if none makes progress
+   */
+  Ipv4Address SpreadNeighbor(const Vector &position, const Vector &nodePos);
+
+  /**
+   *  Progress towards the destination weighted by the metric
+   */
+  double GetScore(Ipv4Address id, double progress) const;
+
+  /**
+   *  Bumps the epoch once a link's quality moved enough to change decisions
+   */
+  void PublishLinkQuality(uint32_t id);
+
+  /**
+   *  Re-sorts the bearing ring around a new center
+   */
+  void RebuildRing(const Vector &center);
+
+  /**
+   *  True if w removes the edge center-v from the selected planar subgraph
+   */
+  bool IsWitness(const Vector &center, const Vector &v, const Vector &w) const;
+
+  /**
+   *  Recomputes all witness counts around a new center, O(n^2)
+   */
+  void RebuildPlanar(const Vector &center);
+
+  /**
+   *  Adds a neighbor to the witness counts, O(n)
+   */
+  void PlanarAdd(uint32_t id, const Vector &position);
+
+  /**
+   *  Removes a neighbor from the witness counts, O(n)
+   */
+  void PlanarRemove(uint32_t id);
+
+  // Planar subgraph entry: the edge to a neighbor is kept while no other
+  // neighbor witnesses it
+  struct PlanarEntry
+  {
+    Vector position;     // Neighbor position
+    uint32_t witnesses;  // Neighbors inside this edge's GG disk / RNG lune
+  };
+
+  // Bearing ring entry, ordered by (bearing, address) so equal bearings
+  // resolve to the lowest address like the address-ordered scan did
+  struct RingEntry
+  {
+    double bearing;    // PseudoAngle around m_ringCenter
+    uint32_t address;  // Neighbor address (host order)
+    Vector position;   // Neighbor position
+  };
+
+  // Expiry record: (deadline in time steps, address). The deadline is the
+  // last update plus the entry's lifetime.
+  typedef std::pair<int64_t, uint32_t> ExpiryRecord;
+
+  // Link quality estimates of a neighbor, moving averages over its frames
+  struct LinkQuality
+  {
+    double prr;           // HELLO reception ratio
+    int64_t lastHeard;    // Last frame heard, in time steps, -1 if none yet
+    double snr;           // SNR of its broadcasts in dB
+    bool hasSnr;          // Set once snr holds a sample
+    double ackRatio;      // Acknowledged fraction of our unicast attempts
+    bool hasAck;          // Set once ackRatio holds a sample
+    double published;     // Quality the last epoch bump was made for
+  };
+
+  // Last advertised motion of a neighbor whose position is predicted
+  struct Motion
+  {
+    Vector position;    // Advertised position
+    Vector velocity;    // Advertised velocity
+    int64_t timestamp;  // When position was sampled, in time steps
+  };
+
   Time m_entryLifetime; // Lifetime of a position table entry
-  std::map<Ipv4Address, std::pair<Vector, Time>> m_table; // Position table
+  Backend m_backend;    // Storage layout in use
+  std::map<Ipv4Address, std::pair<Vector, Time>> m_table; // Position table (MAP_BACKEND)
+
+  // FLAT_BACKEND: structure of arrays kept sorted by address so lookups are a
+  // binary search and scans walk contiguous memory. Neighbors learnt from
+  // HELLOs are 2D, so only x/y are stored.
+  std::vector<uint32_t> m_addrs;  // Neighbor addresses (host order)
+  std::vector<double> m_posX;     // Neighbor X coordinates
+  std::vector<double> m_posY;     // Neighbor Y coordinates
+  std::vector<int64_t> m_stamps;  // Last update, in simulator time steps
+
+  // Min-heap of update records, one pushed per AddEntry. Records whose
+  // stamp no longer matches the entry (refreshed or deleted) are stale and
+  // skipped when popped.
+  std::priority_queue<ExpiryRecord, std::vector<ExpiryRecord>, std::greater<ExpiryRecord> > m_expiry;
+
+  std::vector<RingEntry> m_ring;  // Neighbors sorted by bearing around m_ringCenter
+  Vector m_ringCenter;            // Position the ring was sorted around
+  bool m_ringDirty;               // Set when the neighbor set or a position changed
+
+  // Planar subgraph, maintained incrementally on AddEntry/DeleteEntry and
+  // rebuilt when the local position changes
+  Planarization m_planarization;
+  std::unordered_map<uint32_t, PlanarEntry> m_planar;  // Witness counts by address
+  Vector m_planarCenter;                                // Position the counts refer to
+  bool m_planarValid;                                   // False until first rebuilt
+
+  uint64_t m_epoch;  // Bumped on every change to the neighbor set or a position
+
+  // Position prediction
+  bool m_prediction;                                // Extrapolate neighbors that advertise motion
+  double m_radioRange;                              // Out of range distance, 0 disables the check
+  Time m_predictedLifetime;                         // Lifetime of predicted entries
+  std::unordered_map<uint32_t, Motion> m_motion;    // Predicted entries by address
+  int64_t m_advancedTo;                             // Time the positions were extrapolated to
+  Vector m_rangeCenter;                             // Position of the last range check
+  uint64_t m_rangeEpoch;                            // Epoch of the last range check
+
+  // Link quality
+  Metric m_metric;                                  // Metric BestNeighbor ranks neighbors by
+  std::unordered_map<uint32_t, LinkQuality> m_links; // Estimates by address
+
+  // Load spreading
+  double m_loadTolerance;                           // Score fraction within which neighbors share traffic
+  std::unordered_map<uint32_t, double> m_loads;     // Advertised loads by address
+
+  std::unordered_set<uint32_t> m_static;            // Entries that never expire, by address
+  Ptr<UniformRandomVariable> m_spreadRandom;        // Draws the next hop among candidates, created on first use
+  int64_t m_spreadStream;                           // Stream of m_spreadRandom, -1 for automatic
 };
 
 }
@@ -7,7 +7,10 @@
 
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/simulator.h"
-#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ns3 {
 
@@ -63,6 +66,14 @@ private:
 
 /**
  *  GPSR Request Queue
+ *
+ * Entries live in one list ordered by age, which is also expiry order
+ * since they all share the same timeout. Each destination has a FIFO of
+ * iterators into that list, and a hash set of (src, dst, protocol, id)
+ * keys rejects duplicates, so enqueue, dequeue, find and drop-oldest are
+ * O(1). A single simulator event is kept at the deadline of the oldest
+ * entry, so packets are dropped (and their error callback fired) exactly
+ * when they expire instead of being found by a later rescan.
  */
 class GpsrRqueue
 {
@@ -74,6 +85,11 @@ public:
    */
   GpsrRqueue(uint32_t maxLen, Time timeout);
 
+  /**
+   *  Destructor, cancels the pending expiry event
+   */
+  ~GpsrRqueue();
+
   /**
    *  Check if the queue is empty
    *  True if empty, false otherwise
@@ -138,30 +154,95 @@ public:
    */
   Time GetQueueTimeout() const;
 
+  /**
+   *  Get the number of packets dropped because they expired in the queue
+   *  The expired packet count
+   */
+  uint32_t GetExpiredCount() const;
+
+  /**
+   *  Get the number of packets that left the queue through Dequeue
+   *  The delivered packet count
+   */
+  uint32_t GetDeliveredCount() const;
+
+  /**
+   *  Get the number of packets dropped for any other reason (queue full
+   *  or DropPacketWithDst)
+   *  The dropped packet count
+   */
+  uint32_t GetDroppedCount() const;
+
 private:
-  std::vector<GpsrQueueEntry> m_queue; // Request queue
-  uint32_t m_maxLen;                   // Maximum queue length
-  Time m_queueTimeout;                 // Queue timeout
+  typedef std::list<GpsrQueueEntry> EntryList;
+
+  /**
+   *  Duplicate detection key, the IP fields identifying a datagram
+   */
+  struct DuplicateKey
+  {
+    uint32_t src;
+    uint32_t dst;
+    uint8_t protocol;
+    uint16_t id;
+
+    bool operator==(const DuplicateKey &o) const
+    {
+      return src == o.src && dst == o.dst && protocol == o.protocol && id == o.id;
+    }
+  };
+
+  struct DuplicateKeyHash
+  {
+    std::size_t operator()(const DuplicateKey &k) const
+    {
+      uint64_t h = (static_cast<uint64_t>(k.src) << 32) | k.dst;
+      h ^= (static_cast<uint64_t>(k.protocol) << 16 | k.id) * 0x9E3779B97F4A7C15ULL;
+      return std::hash<uint64_t>()(h);
+    }
+  };
+
+  static DuplicateKey MakeKey(const Ipv4Header &header);
+
+  /**
+   *  Unlinks an entry from the per-destination FIFO, the duplicate set
+   *  and the age list. The entry must be the oldest for its destination.
+   */
+  void Remove(EntryList::iterator i);
+
+  EntryList m_queue;                                              // All entries, oldest first
+  std::unordered_map<uint32_t, std::deque<EntryList::iterator> > m_byDst;  // Per-destination FIFOs
+  std::unordered_set<DuplicateKey, DuplicateKeyHash> m_keys;      // Keys of queued datagrams
+  uint32_t m_maxLen;                                              // Maximum queue length
+  Time m_queueTimeout;                                            // Queue timeout
+  EventId m_expiryEvent;                                          // Fires at the oldest entry's deadline
+  Time m_expiryAt;                                                // Absolute time m_expiryEvent is set for
+  uint32_t m_expired;                                             // Packets dropped on expiry
+  uint32_t m_delivered;                                           // Packets handed out by Dequeue
+  uint32_t m_dropped;                                             // Packets dropped for other reasons
 
   /**
    *  Remove all expired entries
    */
   void Purge();
 
+  /**
+   *  Keep m_expiryEvent at the deadline of the oldest entry, or cancel it
+   *  when the queue is empty
+   */
+  void ScheduleExpiry();
+
+  /**
+   *  Expiry event handler, drops the entries that are due and reschedules
+   */
+  void Expire();
+
   /**
    *  Notify that packet is dropped from queue by timeout
    *  entry The dropped entry
    *  reason The reason for dropping
    */
   void Drop(GpsrQueueEntry entry, std::string reason);
-
-  /**
-   *  Check if an entry matches a destination
-   *  entry The queue entry
-   *  dst The destination IP address
-   *  True if matches, false otherwise
-   */
-  static bool IsEqual(GpsrQueueEntry entry, const Ipv4Address dst);
 };
 
 } // namespace ns3
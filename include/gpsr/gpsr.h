@@ -17,6 +17,12 @@
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-mpdu.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-mac-queue.h"
+#include <unordered_map>
 
 namespace ns3 {
 
@@ -36,6 +42,57 @@ public:
   static TypeId GetTypeId (void);
   static const uint32_t GPSR_PORT;
 
+  /**
+   *  What a data packet carries while it is forwarded in greedy mode
+   */
+  enum DataHeaderMode
+  {
+    DATA_HEADER_FULL = 0,  // Position header from the source to the destination
+    DATA_HEADER_STUB = 1,  // Position header, recovery fields dropped back in greedy mode
+    DATA_HEADER_NONE = 2,  // No header, attached only while in perimeter mode
+  };
+
+  /**
+   *  When HELLO beacons are sent
+   */
+  enum HelloMode
+  {
+    HELLO_FIXED = 0,     // Every HelloInterval, with jitter
+    HELLO_ADAPTIVE = 1,  // After moving HelloDistance or seeing a new neighbor,
+                         // within MinHelloInterval and MaxHelloInterval
+    HELLO_OFF = 2,       // Never, neighbors come from AddStaticNeighbor
+  };
+
+  /**
+   *  Why GPSR dropped a data packet, reported by the "Drop" trace source
+   */
+  enum DropReason
+  {
+    DROP_NO_ROUTE = 0,          // No greedy or perimeter next hop
+    DROP_PERIMETER_LOOP = 1,    // About to traverse the face's first edge again
+    DROP_PERIMETER_BUDGET = 2,  // More than MaxPerimeterHops on the perimeter
+    DROP_TTL = 3,               // TTL ran out while being rerouted
+  };
+
+  /**
+   *  Signature of the "Drop" trace source
+   *  packet The dropped packet
+   *  header Its IP header
+   *  reason Why it was dropped
+   */
+  typedef void (*DropTracedCallback)(Ptr<const Packet> packet, const Ipv4Header &header, DropReason reason);
+
+  /**
+   *  Signature of the "Deliver" trace source
+   *  packet The delivered packet, with its position header stripped
+   *  header Its IP header
+   *  greedyHops Greedy hops the packet took
+   *  perimeterHops Perimeter hops the packet took
+   *  modeSwitches Times the packet entered or left recovery
+   */
+  typedef void (*DeliverTracedCallback)(Ptr<const Packet> packet, const Ipv4Header &header,
+                                        uint32_t greedyHops, uint32_t perimeterHops, uint32_t modeSwitches);
+
   Gpsr();
   virtual ~Gpsr();
   virtual void DoDispose();
@@ -64,8 +121,91 @@ public:
   void RecvGpsr(Ptr<Socket> socket);
   void SendHello();
   void UpdateRouteToNeighbor(Ipv4Address neighbor, Vector position);
+  void UpdateRouteToNeighbor(Ipv4Address neighbor, Vector position, Vector velocity, Time timestamp);
   bool IsMyOwnAddress(Ipv4Address addr);
 
+  // Neighbor table storage layout (see GpsrPtable::Backend)
+  void SetNeighborTableBackend(GpsrPtable::Backend backend);
+  GpsrPtable::Backend GetNeighborTableBackend() const;
+
+  // Planar subgraph used in perimeter mode (see GpsrPtable::Planarization)
+  void SetPlanarization(GpsrPtable::Planarization planarization);
+  GpsrPtable::Planarization GetPlanarization() const;
+
+  // Neighbor position prediction (see GpsrPtable::SetPrediction)
+  void SetPositionPrediction(bool prediction);
+  bool GetPositionPrediction() const;
+  void SetRadioRange(double range);
+  double GetRadioRange() const;
+  void SetPredictedEntryLifetime(Time lifetime);
+  Time GetPredictedEntryLifetime() const;
+
+  // Greedy forwarding metric (see GpsrPtable::Metric)
+  void SetForwardingMetric(GpsrPtable::Metric metric);
+  GpsrPtable::Metric GetForwardingMetric() const;
+
+  // Greedy load spreading (see GpsrPtable::SetLoadTolerance)
+  void SetLoadTolerance(double tolerance);
+  double GetLoadTolerance() const;
+
+  // Smoothed occupancy of the MAC transmit queue, advertised in HELLOs
+  double GetLoad() const;
+
+  // Adds a neighbor known from the true topology. It never expires and
+  // survives the table reset at start-up. Link failures evict it for
+  // StaticHoldDown only.
+  void AddStaticNeighbor(Ipv4Address neighbor, Vector position);
+
+  // Data packets sent or forwarded, and the GPSR header bytes they carried
+  uint32_t GetDataTxCount() const;
+  uint64_t GetDataHeaderBytes() const;
+
+  // Wall-clock time spent making forwarding decisions in RouteInput
+  uint32_t GetForwardedCount() const;
+  int64_t GetForwardingCpuNanoSeconds() const;
+
+  // Packet copies made by GPSR, and data packets delivered locally
+  uint32_t GetPacketCopyCount() const;
+  uint32_t GetDeliveredCount() const;
+
+  // Greedy route cache lookups that hit and missed
+  uint32_t GetRouteCacheHits() const;
+  uint32_t GetRouteCacheMisses() const;
+
+  // HELLO beacons sent and their size including UDP and IP headers
+  uint32_t GetHelloTxCount() const;
+  uint64_t GetHelloBytes() const;
+
+  // HELLOs skipped because data frames had advertised the position, data
+  // frames that carried it, and neighbor refreshes taken from data frames
+  uint32_t GetHelloSuppressedCount() const;
+  uint32_t GetPiggybackTxCount() const;
+  uint32_t GetPiggybackRxCount() const;
+
+  // MAC transmission attempts that failed, frames that used up their
+  // retries, packets rerouted after such a failure, and rerouted packets
+  // that could be neither forwarded nor queued
+  uint32_t GetMacRetryCount() const;
+  uint32_t GetLinkFailureCount() const;
+  uint32_t GetReroutedCount() const;
+  uint32_t GetReroutedDropCount() const;
+
+  // Packets sent on a greedy and on a perimeter hop, and packets switched
+  // between the two modes
+  uint32_t GetGreedyHopCount() const;
+  uint32_t GetPerimeterHopCount() const;
+  uint32_t GetModeSwitchCount() const;
+
+  // Greedy hops, perimeter hops and mode switches summed over the packets
+  // delivered to this node, as counted on each packet along its path
+  uint64_t GetDeliveredGreedyHops() const;
+  uint64_t GetDeliveredPerimeterHops() const;
+  uint64_t GetDeliveredModeSwitches() const;
+
+  // Packets dropped on a perimeter loop and over the perimeter hop budget
+  uint32_t GetPerimeterLoopDropCount() const;
+  uint32_t GetPerimeterBudgetDropCount() const;
+
 private:
   // Start protocol operation
   void Start();
@@ -79,8 +219,16 @@ private:
   // Forward packet using greedy forwarding
   bool ForwardingGreedy(Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb, ErrorCallback ecb);
 
-  // Enter recovery mode when greedy forwarding fails
-  void RecoveryMode(Ipv4Address dst, Ptr<Packet> p, UnicastForwardCallback ucb, Ipv4Header header, const ErrorCallback &ecb);
+  // Starts a perimeter at this node, with myPos as the recovery point
+  void EnterRecovery(Ipv4Address dst, Ptr<const Packet> p, Vector dstPos, Vector myPos,
+                     UnicastForwardCallback ucb, const Ipv4Header &header, const ErrorCallback &ecb);
+
+  // Reports a dropped data packet through the Drop trace and ecb
+  void DropData(Ptr<const Packet> p, const Ipv4Header &header, DropReason reason, const ErrorCallback &ecb);
+
+  // Forward p on the perimeter, gpsrHeader holds its recovery state
+  void RecoveryMode(Ipv4Address dst, Ptr<const Packet> p, GpsrPositionHeader gpsrHeader,
+                    UnicastForwardCallback ucb, Ipv4Header header, const ErrorCallback &ecb);
 
   // Loopback route for self-addressed packets
   Ptr<Ipv4Route> LoopbackRoute(const Ipv4Header & header, Ptr<NetDevice> oif);
@@ -88,14 +236,111 @@ private:
   // Find socket with local interface address
   Ptr<Socket> FindSocketWithInterfaceAddress(Ipv4InterfaceAddress iface) const;
 
-  // Send packet from queue
+  // Send all queued packets for a destination, false if they stay queued
   bool SendPacketFromQueue(Ipv4Address dst);
 
+  // Drain queued destinations a new or moved neighbor makes progress to
+  void DrainQueueTowards(Ipv4Address neighbor, Vector position);
+
   // Check the packet queue
   void CheckQueue();
 
+  // Schedules the next HELLO according to m_helloMode
+  void ScheduleHello();
+
+  // Reschedules an adaptive HELLO after a course change or a new neighbor
+  void ScheduleAdaptiveHello();
+
+  // Run SendHello after delay, on m_helloTimer or in the shared beacon
+  // calendar when m_beaconSlot is set
+  void ScheduleHelloIn(Time delay);
+  void CancelHello();
+  bool IsHelloScheduled() const;
+
+  // Drains the queue and triggers an adaptive HELLO after a neighbor update
+  void NeighborUpdated(Ipv4Address neighbor, Vector position, bool added, bool changed);
+
+  // Puts a static neighbor evicted by a link failure back into the table
+  void RestoreStaticNeighbor(Ipv4Address neighbor);
+
+  // Position header of a data packet, false if it carries none
+  bool PeekPositionHeader(Ptr<const Packet> p, GpsrPositionHeader &gpsrHeader) const;
+
+  // Copy of p carrying gpsrHeader in place of any position header it had;
+  // header's payload size is updated to match
+  Ptr<Packet> SetPositionHeader(Ptr<const Packet> p, const GpsrPositionHeader &gpsrHeader, Ipv4Header &header);
+
+  // Copy of p without its position header; header's payload size is updated
+  Ptr<Packet> StripPositionHeader(Ptr<const Packet> p, Ipv4Header &header);
+
+  // Applies m_dataHeaderMode to a packet leaving perimeter mode
+  Ptr<const Packet> LeaveRecovery(Ptr<const Packet> p, GpsrPositionHeader gpsrHeader, Ipv4Header &header);
+
+  // Route to dst through nextHop on the GPSR interface
+  Ptr<Ipv4Route> MakeRoute(Ipv4Address dst, Ipv4Address nextHop) const;
+
+  // Greedy route towards dstPos through the route cache, null if no
+  // neighbor makes progress
+  Ptr<Ipv4Route> GreedyRoute(Ipv4Address dst, Vector dstPos, Vector myPos);
+
+  // Counts a hop on the packet itself, perimeter or greedy
+  void CountHop(Ptr<const Packet> p, bool perimeter);
+
+  // Hands a data packet to the next hop, counting its header bytes
+  void SendData(const UnicastForwardCallback &ucb, Ptr<Ipv4Route> route, Ptr<const Packet> p, Ipv4Header header);
+
+  // Puts this node's sender header in front of packet, returns its size
+  // or 0 if the position is unknown
+  uint32_t PutSenderHeader(Ptr<Packet> packet, Ipv4Address sender);
+
+  // Copy of p without its sender header; header's payload size is updated
+  Ptr<Packet> StripSenderHeader(Ptr<const Packet> p, Ipv4Header &header);
+
+  // Connects or disconnects the MAC and PHY feedback traces of a WiFi device
+  void SetMacFeedback(Ptr<NetDevice> device, bool connect);
+
+  // Folds the current MAC queue occupancy into m_load
+  void SampleLoad();
+
+  // Neighbor behind a MAC address, or zero if it is not a known neighbor
+  Ipv4Address GetNeighborAddress(Mac48Address address);
+
+  // MAC feedback: a failed attempt, a frame that used up its retries, the
+  // frame being dropped, and a frame that was acknowledged
+  void NotifyTxFailed(Mac48Address address);
+  void NotifyTxFinalFailed(Mac48Address address);
+  void NotifyMacDrop(WifiMacDropReason reason, Ptr<const WifiMpdu> mpdu);
+  void NotifyAcked(Ptr<const WifiMpdu> mpdu);
+
+  // PHY feedback: records the SNR of HELLOs for the link quality estimates
+  void NotifyPhyRx(Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                   MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId);
+
+  // Routes a packet the MAC could not deliver to its next hop again
+  void Reroute(Ptr<Packet> packet, Ipv4Header header);
+
+  // Forward and error callbacks used for rerouted packets
+  void SendRerouted(Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+  void DropRerouted(Ptr<const Packet> p, const Ipv4Header &header, Socket::SocketErrno err);
+
+  // Promiscuous handler refreshing neighbors from the sender header of
+  // every data frame heard on the GPSR interface
+  void OverhearData(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                    const Address &from, const Address &to, NetDevice::PacketType packetType);
+
   // Protocol parameters
   Time m_helloInterval;
+  HelloMode m_helloMode;
+  double m_helloDistance;     // Movement in metres that triggers an adaptive HELLO
+  Time m_minHelloInterval;    // Adaptive HELLOs are at least this far apart
+  Time m_maxHelloInterval;    // and at most this far
+  Time m_beaconSlot;          // Slot of the shared HELLO calendar, 0 for m_helloTimer
+  bool m_helloMotion;         // HELLOs carry velocity and timestamp
+  bool m_piggybackPosition;   // Data frames carry the sender's position
+  bool m_linkFeedback;        // MAC failures evict the next hop and reroute
+  bool m_helloLoad;           // HELLOs carry the MAC queue occupancy
+  bool m_perimeterLoopDetection; // Drop packets about to repeat the face's first edge
+  uint32_t m_maxPerimeterHops;   // Perimeter hop budget per recovery, 0 for none
   uint32_t m_maxQueueLen;
   Time m_maxQueueTime;
 
@@ -103,18 +348,92 @@ private:
   Ptr<Ipv4> m_ipv4;
   std::map<Ptr<Socket>, Ipv4InterfaceAddress> m_socketAddresses;
   Ptr<NetDevice> m_lo;
+  Ptr<NetDevice> m_egressDevice; // Device of the GPSR interface, every next hop is on it
+  int32_t m_egressInterface;     // Interface index of m_egressDevice, -1 if none is up
+  Ptr<WifiMacQueue> m_macQueue;  // Transmit queue of m_egressDevice, if it is WiFi
+  double m_load;                 // Moving average of the m_macQueue occupancy
+  Ptr<MobilityModel> m_mobility; // This node's mobility model
+  Vector m_position;             // Position cached at m_positionTime
+  Time m_positionTime;           // Timestamp m_position was evaluated at
+  bool m_positionValid;          // False until evaluated or after a course change
   GpsrPtable m_neighbors; // Position table for neighbors
   GpsrRqueue m_queue; // Request queue for packets
   bool m_perimeterMode; // Flag for perimeter mode
+  DataHeaderMode m_dataHeaderMode; // Position header carried in greedy mode
   std::list<Ipv4Address> m_queuedAddresses;
+  std::map<Ipv4Address, Vector> m_staticNeighbors; // Added by AddStaticNeighbor
   Ptr<UniformRandomVariable> m_uniformRandomVariable;
+  Time m_staticHoldDown;      // Time an evicted static neighbor stays out of the table
+
+  // Adaptive beaconing state
+  Vector m_lastHelloPos;      // Position advertised by the last HELLO
+  Vector m_lastHelloVelocity; // Velocity it advertised, zero without m_helloMotion
+  Time m_lastHelloTime;       // When it was sent
+  bool m_helloChurn;          // A neighbor appeared since the last HELLO
+  Vector m_lastAdvertPos;     // Position carried by the last data frame
+  Time m_lastAdvertTime;      // When it was sent
+  bool m_advertised;          // False until a data frame carried the position
 
   // Timers
   Timer m_helloTimer;
+  uint64_t m_beaconId;        // Pending HELLO in the shared beacon calendar
   Timer m_queueTimer;
 
   // Callbacks
-  IpL4Protocol::DownTargetCallback m_downTarget;
+  IpL4Protocol::DownTargetCallback m_downTarget; // UDP's original path down to IP
+
+  // Statistics
+  uint32_t m_dataTx;              // Data packets sent or forwarded
+  uint64_t m_dataHeaderBytes;     // GPSR header bytes on those packets
+  uint32_t m_forwarded;           // Packets that went through ForwardingGreedy
+  int64_t m_forwardingCpu;        // Wall-clock nanoseconds spent in ForwardingGreedy
+  uint32_t m_packetCopies;        // Packet::Copy calls made by GPSR
+  uint32_t m_delivered;           // Data packets delivered to this node
+
+  // Greedy route cache: destination address to prebuilt route and the
+  // destination position it was chosen for. Valid for one neighbor table
+  // epoch and one position of this node.
+  struct RouteCacheEntry
+  {
+    Vector dstPos;                // Destination position the route was chosen for
+    Ptr<Ipv4Route> route;         // Null if no neighbor made progress
+  };
+  double m_routeCacheBucket;      // Bucket side in metres hits may differ by, 0 for exact positions
+  std::unordered_map<uint32_t, RouteCacheEntry> m_routeCache;
+  uint64_t m_routeCacheEpoch;     // GpsrPtable epoch the entries were computed in
+  Vector m_routeCachePos;         // Our position when they were computed
+  uint32_t m_routeCacheHits;      // Lookups answered from the cache
+  uint32_t m_routeCacheMisses;    // Lookups that ran BestNeighbor
+
+  uint32_t m_helloTx;             // HELLO beacons sent
+  uint64_t m_helloBytes;          // Their bytes on the wire above the MAC
+  uint32_t m_helloSuppressed;     // HELLOs replaced by data frames
+  uint32_t m_piggybackTx;         // Data frames sent with a sender header
+  uint32_t m_piggybackRx;         // Neighbor refreshes taken from data frames
+
+  uint32_t m_macRetries;          // Failed MAC transmission attempts
+  uint32_t m_linkFailures;        // Frames that used up their MAC retries
+  uint32_t m_rerouted;            // Packets handed back to routing after one
+  uint32_t m_reroutedDrops;       // Rerouted packets lost for lack of a route
+
+  uint32_t m_greedyHops;          // Packets sent to a greedy next hop
+  uint32_t m_perimeterHops;       // Packets sent to a perimeter next hop
+  uint32_t m_modeSwitches;        // Packets entering or leaving recovery
+  uint32_t m_perimeterLoopDrops;  // Packets dropped on a perimeter loop
+  uint32_t m_perimeterBudgetDrops; // Packets dropped over the perimeter hop budget
+  uint64_t m_deliveredGreedyHops;  // Greedy hops of the packets delivered here
+  uint64_t m_deliveredPerimeterHops; // Perimeter hops of the packets delivered here
+  uint64_t m_deliveredModeSwitches; // Mode switches of the packets delivered here
+
+  TracedCallback<Ptr<const Packet>, const Ipv4Header &, DropReason> m_dropTrace;
+  TracedCallback<Ptr<const Packet>, const Ipv4Header &, uint32_t, uint32_t, uint32_t> m_deliverTrace;
+
+  // Caches the node's mobility model and follows its course changes
+  void SetMobilityModel(Ptr<MobilityModel> mobility);
+  void NotifyCourseChange(Ptr<const MobilityModel> mobility);
+
+  // Current position of this node, evaluated once per timestamp
+  bool GetMyPosition(Vector &position);
 
   // New methods for position management and recovery mode
   Vector GetNodePosition(Ptr<Node> node);
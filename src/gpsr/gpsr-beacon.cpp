@@ -0,0 +1,127 @@
+#include "gpsr/gpsr-beacon.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("GpsrBeacon");
+
+GpsrBeaconScheduler::GpsrBeaconScheduler() :
+  m_slotEventDue(0),
+  m_nextId(1),
+  m_slotEvents(0),
+  m_dispatched(0)
+{
+}
+
+GpsrBeaconScheduler::~GpsrBeaconScheduler()
+{
+  m_slotEvent.Cancel();
+}
+
+uint64_t
+GpsrBeaconScheduler::Schedule(Time delay, Time slot, Callback<void> beacon)
+{
+  NS_ASSERT_MSG(slot.IsStrictlyPositive(), "Beacon slots must be longer than zero");
+
+  int64_t width = slot.GetTimeStep();
+  int64_t due = (Simulator::Now() + std::max(delay, Time(0))).GetTimeStep();
+  due = (due + width - 1) / width * width;
+
+  uint64_t id = m_nextId++;
+  m_beacons[id] = Beacon{due, beacon};
+  m_calendar[due].push_back(id);
+  NS_LOG_LOGIC("Beacon " << id << " due at " << TimeStep(due).As(Time::S));
+
+  ScheduleSlot();
+  return id;
+}
+
+void
+GpsrBeaconScheduler::Cancel(uint64_t id)
+{
+  std::unordered_map<uint64_t, Beacon>::iterator beacon = m_beacons.find(id);
+  if (beacon == m_beacons.end()) {
+    return;
+  }
+
+  std::map<int64_t, std::vector<uint64_t>>::iterator slot = m_calendar.find(beacon->second.due);
+  m_beacons.erase(beacon);
+  if (slot == m_calendar.end()) {
+    return;
+  }
+  std::vector<uint64_t> &ids = slot->second;
+  std::vector<uint64_t>::iterator i = std::find(ids.begin(), ids.end(), id);
+  if (i != ids.end()) {
+    *i = ids.back();
+    ids.pop_back();
+  }
+  if (ids.empty()) {
+    m_calendar.erase(slot);
+    ScheduleSlot();
+  }
+}
+
+bool
+GpsrBeaconScheduler::IsPending(uint64_t id) const
+{
+  return m_beacons.find(id) != m_beacons.end();
+}
+
+uint64_t
+GpsrBeaconScheduler::GetSlotEventCount() const
+{
+  return m_slotEvents;
+}
+
+uint64_t
+GpsrBeaconScheduler::GetDispatchCount() const
+{
+  return m_dispatched;
+}
+
+void
+GpsrBeaconScheduler::ScheduleSlot()
+{
+  if (m_calendar.empty()) {
+    m_slotEvent.Cancel();
+    return;
+  }
+
+  int64_t earliest = m_calendar.begin()->first;
+  if (m_slotEvent.IsPending() && m_slotEventDue == earliest) {
+    return;
+  }
+  m_slotEvent.Cancel();
+  m_slotEventDue = earliest;
+  m_slotEvent = Simulator::Schedule(TimeStep(earliest) - Simulator::Now(), &GpsrBeaconScheduler::RunSlot, this);
+}
+
+void
+GpsrBeaconScheduler::RunSlot()
+{
+  ++m_slotEvents;
+
+  // Beacons scheduled by the ones run here go into later slots, or into a
+  // new vector for this one, so the ids are taken out first
+  std::vector<uint64_t> ids;
+  ids.swap(m_calendar.begin()->second);
+  m_calendar.erase(m_calendar.begin());
+
+  for (uint64_t id : ids) {
+    std::unordered_map<uint64_t, Beacon>::iterator beacon = m_beacons.find(id);
+    if (beacon == m_beacons.end()) {
+      continue;
+    }
+    Callback<void> run = beacon->second.beacon;
+    m_beacons.erase(beacon);
+    ++m_dispatched;
+    run();
+  }
+  NS_LOG_LOGIC("Slot at " << Simulator::Now().As(Time::S) << " ran " << ids.size() << " beacons");
+
+  ScheduleSlot();
+}
+
+} // namespace ns3
@@ -0,0 +1,242 @@
+#include "gpsr/gpsr-greedy-kernel.h"
+#include <cmath>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define GPSR_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+
+namespace {
+
+// Same operation order as Vector3D::GetLength() on (dst - neighbor), so the
+// sqrt of this value is bit-identical to CalculateDistance(neighbor, dst).
+// The project builds with -std=c++23 (no GNU extensions), so GCC does not
+// contract these into FMAs.
+inline double
+SquaredDistance(double x, double y, double dstX, double dstY, double dz2)
+{
+  double dx = dstX - x;
+  double dy = dstY - y;
+  return dx * dx + dy * dy + dz2;
+}
+
+double
+MinSquaredScalar(const double *xs, const double *ys, std::size_t begin, std::size_t n,
+                 double dstX, double dstY, double dz2, double current)
+{
+  for (std::size_t i = begin; i < n; ++i) {
+    double d2 = SquaredDistance(xs[i], ys[i], dstX, dstY, dz2);
+    if (d2 < current) {
+      current = d2;
+    }
+  }
+  return current;
+}
+
+std::size_t
+FirstAtMostScalar(const double *xs, const double *ys, std::size_t begin, std::size_t n,
+                  double dstX, double dstY, double dz2, double bound)
+{
+  for (std::size_t i = begin; i < n; ++i) {
+    if (SquaredDistance(xs[i], ys[i], dstX, dstY, dz2) <= bound) {
+      return i;
+    }
+  }
+  return n;
+}
+
+#ifdef GPSR_KERNEL_X86
+
+__attribute__((target("sse2"))) double
+MinSquaredSse2(const double *xs, const double *ys, std::size_t n,
+               double dstX, double dstY, double dz2)
+{
+  __m128d px = _mm_set1_pd(dstX);
+  __m128d py = _mm_set1_pd(dstY);
+  __m128d pz = _mm_set1_pd(dz2);
+  __m128d best = _mm_set1_pd(std::numeric_limits<double>::infinity());
+
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d dx = _mm_sub_pd(px, _mm_loadu_pd(xs + i));
+    __m128d dy = _mm_sub_pd(py, _mm_loadu_pd(ys + i));
+    __m128d d2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), pz);
+    // min returns the second operand on NaN, so NaN lanes never win
+    best = _mm_min_pd(d2, best);
+  }
+
+  double lanes[2];
+  _mm_storeu_pd(lanes, best);
+  double current = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+  return MinSquaredScalar(xs, ys, i, n, dstX, dstY, dz2, current);
+}
+
+__attribute__((target("sse2"))) std::size_t
+FirstAtMostSse2(const double *xs, const double *ys, std::size_t n,
+                double dstX, double dstY, double dz2, double bound)
+{
+  __m128d px = _mm_set1_pd(dstX);
+  __m128d py = _mm_set1_pd(dstY);
+  __m128d pz = _mm_set1_pd(dz2);
+  __m128d limit = _mm_set1_pd(bound);
+
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d dx = _mm_sub_pd(px, _mm_loadu_pd(xs + i));
+    __m128d dy = _mm_sub_pd(py, _mm_loadu_pd(ys + i));
+    __m128d d2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), pz);
+    int mask = _mm_movemask_pd(_mm_cmple_pd(d2, limit));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return FirstAtMostScalar(xs, ys, i, n, dstX, dstY, dz2, bound);
+}
+
+__attribute__((target("avx2"))) double
+MinSquaredAvx2(const double *xs, const double *ys, std::size_t n,
+               double dstX, double dstY, double dz2)
+{
+  __m256d px = _mm256_set1_pd(dstX);
+  __m256d py = _mm256_set1_pd(dstY);
+  __m256d pz = _mm256_set1_pd(dz2);
+  __m256d best = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d dx = _mm256_sub_pd(px, _mm256_loadu_pd(xs + i));
+    __m256d dy = _mm256_sub_pd(py, _mm256_loadu_pd(ys + i));
+    __m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), pz);
+    best = _mm256_min_pd(d2, best);
+  }
+
+  double lanes[4];
+  _mm256_storeu_pd(lanes, best);
+  double current = lanes[0];
+  for (int l = 1; l < 4; ++l) {
+    if (lanes[l] < current) {
+      current = lanes[l];
+    }
+  }
+  return MinSquaredScalar(xs, ys, i, n, dstX, dstY, dz2, current);
+}
+
+__attribute__((target("avx2"))) std::size_t
+FirstAtMostAvx2(const double *xs, const double *ys, std::size_t n,
+                double dstX, double dstY, double dz2, double bound)
+{
+  __m256d px = _mm256_set1_pd(dstX);
+  __m256d py = _mm256_set1_pd(dstY);
+  __m256d pz = _mm256_set1_pd(dz2);
+  __m256d limit = _mm256_set1_pd(bound);
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d dx = _mm256_sub_pd(px, _mm256_loadu_pd(xs + i));
+    __m256d dy = _mm256_sub_pd(py, _mm256_loadu_pd(ys + i));
+    __m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), pz);
+    int mask = _mm256_movemask_pd(_mm256_cmp_pd(d2, limit, _CMP_LE_OQ));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return FirstAtMostScalar(xs, ys, i, n, dstX, dstY, dz2, bound);
+}
+
+#endif // GPSR_KERNEL_X86
+
+GpsrGreedyKernel::Isa
+DetectIsa()
+{
+#ifdef GPSR_KERNEL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return GpsrGreedyKernel::AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return GpsrGreedyKernel::SSE2;
+  }
+#endif
+  return GpsrGreedyKernel::SCALAR;
+}
+
+} // namespace
+
+GpsrGreedyKernel::Isa
+GpsrGreedyKernel::GetIsa()
+{
+  static const Isa isa = DetectIsa();
+  return isa;
+}
+
+std::size_t
+GpsrGreedyKernel::ArgMin(const double *xs, const double *ys, std::size_t n,
+                         double dstX, double dstY, double dstZ, double &distance)
+{
+  return ArgMin(GetIsa(), xs, ys, n, dstX, dstY, dstZ, distance);
+}
+
+std::size_t
+GpsrGreedyKernel::ArgMin(Isa isa, const double *xs, const double *ys, std::size_t n,
+                         double dstX, double dstY, double dstZ, double &distance)
+{
+  if (isa > GetIsa()) {
+    isa = GetIsa();
+  }
+
+  // Neighbors are stored in 2D, so the z term is the same for all of them
+  double dz2 = dstZ * dstZ;
+
+  // Pass 1: smallest squared distance
+  double minimum;
+#ifdef GPSR_KERNEL_X86
+  if (isa == AVX2) {
+    minimum = MinSquaredAvx2(xs, ys, n, dstX, dstY, dz2);
+  } else if (isa == SSE2) {
+    minimum = MinSquaredSse2(xs, ys, n, dstX, dstY, dz2);
+  } else
+#endif
+  {
+    minimum = MinSquaredScalar(xs, ys, 0, n, dstX, dstY, dz2, std::numeric_limits<double>::infinity());
+  }
+
+  // Several squared distances can round to the same sqrt. The scalar loop
+  // keeps the first of those, so widen the bound to the largest value with
+  // that sqrt and take the first index below it.
+  distance = std::sqrt(minimum);
+  double bound = minimum;
+  if (std::isfinite(minimum)) {
+    for (;;) {
+      double next = std::nextafter(bound, std::numeric_limits<double>::infinity());
+      if (std::sqrt(next) != distance) {
+        break;
+      }
+      bound = next;
+    }
+  }
+
+  // Pass 2: first index within the bound
+  std::size_t index;
+#ifdef GPSR_KERNEL_X86
+  if (isa == AVX2) {
+    index = FirstAtMostAvx2(xs, ys, n, dstX, dstY, dz2, bound);
+  } else if (isa == SSE2) {
+    index = FirstAtMostSse2(xs, ys, n, dstX, dstY, dz2, bound);
+  } else
+#endif
+  {
+    index = FirstAtMostScalar(xs, ys, 0, n, dstX, dstY, dz2, bound);
+  }
+
+  if (index == n) {
+    // Only reachable when every distance is NaN
+    index = 0;
+    distance = std::sqrt(SquaredDistance(xs[0], ys[0], dstX, dstY, dz2));
+  }
+  return index;
+}
+
+} // namespace ns3
@@ -7,6 +7,10 @@
 #include "ns3/callback.h"
 #include "ns3/udp-l4-protocol.h"
 #include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include <cmath>
+#include <unordered_map>
+#include <vector>
 NS_LOG_COMPONENT_DEFINE("GpsrHelper");  // Define the log component
 
 namespace ns3 {
@@ -72,4 +76,72 @@ GpsrHelper::Install() const
         }
     }
 
+    uint64_t
+    GpsrHelper::PopulateNeighbors(NodeContainer nodes, double range, Ptr<PropagationLossModel> loss,
+                                  double txPower, double rxThreshold)
+    {
+        NS_ASSERT_MSG(range > 0, "Neighbor range must be positive");
+
+        // Grid cells are packed into one key, the two cell coordinates as
+        // 32-bit halves
+        std::vector<Ptr<MobilityModel>> mobility(nodes.GetN());
+        std::vector<Ipv4Address> addresses(nodes.GetN());
+        std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+        auto cellKey = [](int64_t cx, int64_t cy) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+        };
+
+        for (uint32_t i = 0; i < nodes.GetN(); ++i) {
+            Ptr<Node> node = nodes.Get(i);
+            Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+            mobility[i] = node->GetObject<MobilityModel>();
+            if (!mobility[i] || !node->GetObject<Gpsr>() || !ipv4 || ipv4->GetNInterfaces() < 2) {
+                NS_LOG_WARN("Node " << node->GetId() << " lacks GPSR, a position or an address, skipped");
+                mobility[i] = nullptr;
+                continue;
+            }
+            addresses[i] = ipv4->GetAddress(1, 0).GetLocal();
+
+            Vector position = mobility[i]->GetPosition();
+            cells[cellKey(static_cast<int64_t>(std::floor(position.x / range)),
+                          static_cast<int64_t>(std::floor(position.y / range)))].push_back(i);
+        }
+
+        uint64_t added = 0;
+        for (uint32_t i = 0; i < nodes.GetN(); ++i) {
+            if (!mobility[i]) {
+                continue;
+            }
+            Ptr<Gpsr> gpsr = nodes.Get(i)->GetObject<Gpsr>();
+            Vector position = mobility[i]->GetPosition();
+            int64_t cx = static_cast<int64_t>(std::floor(position.x / range));
+            int64_t cy = static_cast<int64_t>(std::floor(position.y / range));
+
+            for (int64_t dx = -1; dx <= 1; ++dx) {
+                for (int64_t dy = -1; dy <= 1; ++dy) {
+                    std::unordered_map<uint64_t, std::vector<uint32_t>>::const_iterator cell =
+                        cells.find(cellKey(cx + dx, cy + dy));
+                    if (cell == cells.end()) {
+                        continue;
+                    }
+                    for (uint32_t j : cell->second) {
+                        if (j == i || mobility[i]->GetDistanceFrom(mobility[j]) > range) {
+                            continue;
+                        }
+                        if (loss && loss->CalcRxPower(txPower, mobility[j], mobility[i]) < rxThreshold) {
+                            continue;
+                        }
+                        // HELLOs advertise positions in the plane
+                        Vector other = mobility[j]->GetPosition();
+                        gpsr->AddStaticNeighbor(addresses[j], Vector(other.x, other.y, 0));
+                        ++added;
+                    }
+                }
+            }
+        }
+
+        NS_LOG_INFO("Populated " << added << " static neighbor entries for " << nodes.GetN() << " nodes");
+        return added;
+    }
+
 } // namespace ns3
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "gpsr/gpsr-location.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("GpsrLocationService");
+
+std::unordered_map<uint32_t, GpsrLocationService::Entry> &
+GpsrLocationService::GetTable()
+{
+  static std::unordered_map<uint32_t, Entry> table;
+  return table;
+}
+
+void
+GpsrLocationService::AddAddress(Ipv4Address addr, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION(addr << (node ? node->GetId() : 0));
+  NS_ASSERT(node != nullptr);
+
+  std::unordered_map<uint32_t, Entry> &table = GetTable();
+  if (table.empty()) {
+    // Drop all node references together with the simulation
+    Simulator::ScheduleDestroy(&GpsrLocationService::Clear);
+  }
+
+  Entry &entry = table[addr.Get()];
+  entry.node = node;
+  // Resolve now if mobility is already installed, otherwise on first lookup
+  entry.mobility = node->GetObject<MobilityModel>();
+}
+
+void
+GpsrLocationService::RemoveAddress(Ipv4Address addr)
+{
+  NS_LOG_FUNCTION(addr);
+  GetTable().erase(addr.Get());
+}
+
+Ptr<MobilityModel>
+GpsrLocationService::GetMobilityModel(Ipv4Address addr)
+{
+  std::unordered_map<uint32_t, Entry> &table = GetTable();
+  std::unordered_map<uint32_t, Entry>::iterator i = table.find(addr.Get());
+  if (i == table.end()) {
+    return nullptr;
+  }
+
+  if (!i->second.mobility) {
+    i->second.mobility = i->second.node->GetObject<MobilityModel>();
+    if (!i->second.mobility) {
+      NS_LOG_WARN("Node " << i->second.node->GetId() << " owning " << addr << " has no mobility model.");
+    }
+  }
+  return i->second.mobility;
+}
+
+bool
+GpsrLocationService::GetPosition(Ipv4Address addr, Vector &position)
+{
+  Ptr<MobilityModel> mobility = GetMobilityModel(addr);
+  if (!mobility) {
+    return false;
+  }
+  position = mobility->GetPosition();
+  return true;
+}
+
+uint32_t
+GpsrLocationService::GetSize()
+{
+  return GetTable().size();
+}
+
+void
+GpsrLocationService::Clear()
+{
+  GetTable().clear();
+}
+
+} // namespace ns3
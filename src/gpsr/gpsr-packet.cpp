@@ -2,12 +2,107 @@
 #include "ns3/address-utils.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/global-value.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring> // Added for memcpy
+#include <limits>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE("GpsrPacket");
 
+/***************************************************
+ *            Header Format
+ ***************************************************/
+
+static GlobalValue g_gpsrHeaderFormat("GpsrHeaderFormat",
+                                      "Wire encoding of the GPSR Hello and Position headers",
+                                      EnumValue(GPSR_FORMAT_RAW),
+                                      MakeEnumChecker(GPSR_FORMAT_RAW, "Raw",
+                                                      GPSR_FORMAT_COMPACT, "Compact"));
+
+GpsrHeaderFormat
+GetGpsrHeaderFormat()
+{
+  EnumValue<GpsrHeaderFormat> value;
+  g_gpsrHeaderFormat.GetValue(value);
+  return value.Get();
+}
+
+namespace {
+
+// Version carried in the high nibble of the first byte of compact headers,
+// the low nibble holds flags. Raw Hello headers with optional fields send
+// the same flags in a trailing byte of their own.
+const uint8_t COMPACT_VERSION = 1;
+const uint8_t COMPACT_FLAG_RECOVERY = 0x01;
+const uint8_t COMPACT_FLAG_MOTION = 0x02;
+const uint8_t COMPACT_FLAG_LOAD = 0x04;
+
+// Compact velocities are cm/s in a signed 16-bit integer (+/- 327 m/s),
+// timestamps are milliseconds of simulation time in 32 bits (49 days)
+const double COMPACT_VELOCITY_SCALE = 100.0;
+
+// Compact coordinates are millimetres in a signed 32-bit integer, which
+// covers +/- 2147 km
+const double COMPACT_SCALE = 1000.0;
+
+void
+WriteCoordinate(Buffer::Iterator &i, double v)
+{
+  double scaled = std::round(v * COMPACT_SCALE);
+  int32_t fixed;
+  if (!(scaled > std::numeric_limits<int32_t>::min())) { // also catches NaN
+    fixed = std::numeric_limits<int32_t>::min();
+  } else if (scaled >= std::numeric_limits<int32_t>::max()) {
+    fixed = std::numeric_limits<int32_t>::max();
+  } else {
+    fixed = static_cast<int32_t>(scaled);
+  }
+  i.WriteHtonU32(static_cast<uint32_t>(fixed));
+}
+
+double
+ReadCoordinate(Buffer::Iterator &i)
+{
+  return static_cast<int32_t>(i.ReadNtohU32()) / COMPACT_SCALE;
+}
+
+void
+WriteVelocity(Buffer::Iterator &i, double v)
+{
+  double scaled = std::round(v * COMPACT_VELOCITY_SCALE);
+  int16_t fixed;
+  if (!(scaled > std::numeric_limits<int16_t>::min())) { // also catches NaN
+    fixed = std::numeric_limits<int16_t>::min();
+  } else if (scaled >= std::numeric_limits<int16_t>::max()) {
+    fixed = std::numeric_limits<int16_t>::max();
+  } else {
+    fixed = static_cast<int16_t>(scaled);
+  }
+  i.WriteHtonU16(static_cast<uint16_t>(fixed));
+}
+
+double
+ReadVelocity(Buffer::Iterator &i)
+{
+  return static_cast<int16_t>(i.ReadNtohU16()) / COMPACT_VELOCITY_SCALE;
+}
+
+uint8_t
+ReadCompactFlags(Buffer::Iterator &i)
+{
+  uint8_t first = i.ReadU8();
+  if ((first >> 4) != COMPACT_VERSION) {
+    NS_LOG_WARN("Compact GPSR header with unknown version " << static_cast<int>(first >> 4));
+  }
+  return first & 0x0F;
+}
+
+} // namespace
+
 /***************************************************
  *            Type Header Implementation
  ***************************************************/
@@ -123,8 +218,14 @@ operator<<(std::ostream & os, GpsrTypeHeader const & h)
 NS_OBJECT_ENSURE_REGISTERED(GpsrHelloHeader);
 
 GpsrHelloHeader::GpsrHelloHeader(double x, double y) :
+  m_format(GetGpsrHeaderFormat()),
   m_positionX(x),
-  m_positionY(y)
+  m_positionY(y),
+  m_hasMotion(false),
+  m_velocityX(0.0),
+  m_velocityY(0.0),
+  m_hasLoad(false),
+  m_load(0)
 {
 }
 
@@ -147,23 +248,112 @@ GpsrHelloHeader::GetInstanceTypeId() const
 uint32_t
 GpsrHelloHeader::GetSerializedSize() const
 {
-  return sizeof(double) * 2;
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    uint32_t size = sizeof(uint8_t) + sizeof(int32_t) * 2;
+    if (m_hasMotion) {
+      size += sizeof(int16_t) * 2 + sizeof(uint32_t);
+    }
+    if (m_hasLoad) {
+      size += sizeof(uint8_t);
+    }
+    return size;
+  }
+  // The flags byte is only sent with an optional field
+  uint32_t size = sizeof(double) * 2;
+  if (m_hasMotion) {
+    size += sizeof(double) * 2 + sizeof(int64_t);
+  }
+  if (m_hasLoad) {
+    size += sizeof(uint8_t);
+  }
+  if (m_hasMotion || m_hasLoad) {
+    size += sizeof(uint8_t);
+  }
+  return size;
 }
 
 void
 GpsrHelloHeader::Serialize(Buffer::Iterator i) const
 {
   NS_LOG_DEBUG("Serialize X " << m_positionX << " Y " << m_positionY);
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    i.WriteU8((COMPACT_VERSION << 4) | (m_hasMotion ? COMPACT_FLAG_MOTION : 0) |
+              (m_hasLoad ? COMPACT_FLAG_LOAD : 0));
+    WriteCoordinate(i, m_positionX);
+    WriteCoordinate(i, m_positionY);
+    if (m_hasMotion) {
+      WriteVelocity(i, m_velocityX);
+      WriteVelocity(i, m_velocityY);
+      i.WriteHtonU32(static_cast<uint32_t>(m_timestamp.GetMilliSeconds()));
+    }
+    if (m_hasLoad) {
+      i.WriteU8(m_load);
+    }
+    return;
+  }
   i.Write((uint8_t*)&m_positionX, sizeof(double));
   i.Write((uint8_t*)&m_positionY, sizeof(double));
+  if (m_hasMotion) {
+    int64_t timestamp = m_timestamp.GetTimeStep();
+    i.Write((uint8_t*)&m_velocityX, sizeof(double));
+    i.Write((uint8_t*)&m_velocityY, sizeof(double));
+    i.Write((uint8_t*)&timestamp, sizeof(int64_t));
+  }
+  if (m_hasLoad) {
+    i.WriteU8(m_load);
+  }
+  if (m_hasMotion || m_hasLoad) {
+    i.WriteU8((m_hasMotion ? COMPACT_FLAG_MOTION : 0) | (m_hasLoad ? COMPACT_FLAG_LOAD : 0));
+  }
 }
 
 uint32_t
 GpsrHelloHeader::Deserialize(Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
-  i.Read((uint8_t*)&m_positionX, sizeof(double));
-  i.Read((uint8_t*)&m_positionY, sizeof(double));
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    uint8_t flags = ReadCompactFlags(i);
+    m_hasMotion = (flags & COMPACT_FLAG_MOTION) != 0;
+    m_hasLoad = (flags & COMPACT_FLAG_LOAD) != 0;
+    m_positionX = ReadCoordinate(i);
+    m_positionY = ReadCoordinate(i);
+    if (m_hasMotion) {
+      m_velocityX = ReadVelocity(i);
+      m_velocityY = ReadVelocity(i);
+      m_timestamp = MilliSeconds(i.ReadNtohU32());
+    }
+    if (m_hasLoad) {
+      m_load = i.ReadU8();
+    }
+  } else {
+    i.Read((uint8_t*)&m_positionX, sizeof(double));
+    i.Read((uint8_t*)&m_positionY, sizeof(double));
+
+    // The Hello header ends the packet. A plain one stops after the
+    // coordinates, otherwise its last byte flags the fields in between.
+    uint8_t flags = 0;
+    uint32_t remaining = i.GetRemainingSize();
+    if (remaining > 0) {
+      Buffer::Iterator last = i;
+      last.Next(remaining - 1);
+      flags = last.ReadU8();
+    }
+    m_hasMotion = (flags & COMPACT_FLAG_MOTION) != 0;
+    m_hasLoad = (flags & COMPACT_FLAG_LOAD) != 0;
+    if (m_hasMotion) {
+      int64_t timestamp;
+      i.Read((uint8_t*)&m_velocityX, sizeof(double));
+      i.Read((uint8_t*)&m_velocityY, sizeof(double));
+      i.Read((uint8_t*)&timestamp, sizeof(int64_t));
+      m_timestamp = TimeStep(static_cast<uint64_t>(timestamp));
+    }
+    if (m_hasLoad) {
+      m_load = i.ReadU8();
+    }
+    if (m_hasMotion || m_hasLoad) {
+      i.ReadU8();
+    }
+  }
 
   NS_LOG_DEBUG("Deserialize X " << m_positionX << " Y " << m_positionY);
 
@@ -177,6 +367,14 @@ GpsrHelloHeader::Print(std::ostream &os) const
 {
   os << " PositionX: " << m_positionX
      << " PositionY: " << m_positionY;
+  if (m_hasMotion) {
+    os << " VelocityX: " << m_velocityX
+       << " VelocityY: " << m_velocityY
+       << " Timestamp: " << m_timestamp.As(Time::S);
+  }
+  if (m_hasLoad) {
+    os << " Load: " << GetLoad();
+  }
 }
 
 void
@@ -203,10 +401,65 @@ GpsrHelloHeader::GetPositionY() const
   return m_positionY;
 }
 
+void
+GpsrHelloHeader::SetMotion(double vx, double vy, Time timestamp)
+{
+  m_hasMotion = true;
+  m_velocityX = vx;
+  m_velocityY = vy;
+  m_timestamp = timestamp;
+}
+
+bool
+GpsrHelloHeader::HasMotion() const
+{
+  return m_hasMotion;
+}
+
+double
+GpsrHelloHeader::GetVelocityX() const
+{
+  return m_velocityX;
+}
+
+double
+GpsrHelloHeader::GetVelocityY() const
+{
+  return m_velocityY;
+}
+
+Time
+GpsrHelloHeader::GetTimestamp() const
+{
+  return m_timestamp;
+}
+
+void
+GpsrHelloHeader::SetLoad(double load)
+{
+  m_hasLoad = true;
+  m_load = static_cast<uint8_t>(std::round(std::min(1.0, std::max(0.0, load)) * 255));
+}
+
+bool
+GpsrHelloHeader::HasLoad() const
+{
+  return m_hasLoad;
+}
+
+double
+GpsrHelloHeader::GetLoad() const
+{
+  return m_load / 255.0;
+}
+
 bool
 GpsrHelloHeader::operator==(GpsrHelloHeader const & o) const
 {
-  return m_positionX == o.m_positionX && m_positionY == o.m_positionY;
+  return m_positionX == o.m_positionX && m_positionY == o.m_positionY &&
+         m_hasMotion == o.m_hasMotion && m_velocityX == o.m_velocityX &&
+         m_velocityY == o.m_velocityY && m_timestamp == o.m_timestamp &&
+         m_hasLoad == o.m_hasLoad && m_load == o.m_load;
 }
 
 std::ostream &
@@ -224,7 +477,9 @@ NS_OBJECT_ENSURE_REGISTERED(GpsrPositionHeader);
 
 GpsrPositionHeader::GpsrPositionHeader(double dstX, double dstY, uint32_t updated,
                                      double recX, double recY, bool recoveryFlag,
-                                     double prevX, double prevY) :
+                                     double prevX, double prevY,
+                                     double faceX, double faceY) :
+  m_format(GetGpsrHeaderFormat()),
   m_dstPositionX(dstX),
   m_dstPositionY(dstY),
   m_updated(updated),
@@ -232,7 +487,14 @@ GpsrPositionHeader::GpsrPositionHeader(double dstX, double dstY, uint32_t update
   m_recPositionY(recY),
   m_recoveryFlag(static_cast<uint8_t>(recoveryFlag)),
   m_prevPositionX(prevX),
-  m_prevPositionY(prevY)
+  m_prevPositionY(prevY),
+  m_facePositionX(faceX),
+  m_facePositionY(faceY),
+  m_edgeFromX(0.0),
+  m_edgeFromY(0.0),
+  m_edgeToX(0.0),
+  m_edgeToY(0.0),
+  m_perimeterHops(0)
 {
 }
 
@@ -255,7 +517,22 @@ GpsrPositionHeader::GetInstanceTypeId() const
 uint32_t
 GpsrPositionHeader::GetSerializedSize() const
 {
-  return sizeof(double) * 6 + sizeof(uint32_t) + sizeof(uint8_t);
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    // flags, dst, updated, then rec/prev/face/first edge and the perimeter
+    // hop count only in recovery
+    uint32_t size = sizeof(uint8_t) + sizeof(int32_t) * 2 + sizeof(uint32_t);
+    if (m_recoveryFlag) {
+      size += sizeof(int32_t) * 10 + sizeof(uint16_t);
+    }
+    return size;
+  }
+  // dst, rec, prev, updated and the flag as before the perimeter state was
+  // added, the face, first edge and perimeter hop count only in recovery
+  uint32_t size = sizeof(double) * 6 + sizeof(uint32_t) + sizeof(uint8_t);
+  if (m_recoveryFlag) {
+    size += sizeof(double) * 6 + sizeof(uint16_t);
+  }
+  return size;
 }
 
 void
@@ -266,6 +543,27 @@ GpsrPositionHeader::Serialize(Buffer::Iterator i) const
                << " PrevX " << m_prevPositionX << " PrevY " << m_prevPositionY 
                << " Updated " << m_updated << " Recovery " << static_cast<bool>(m_recoveryFlag));
 
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    i.WriteU8((COMPACT_VERSION << 4) | (m_recoveryFlag ? COMPACT_FLAG_RECOVERY : 0));
+    WriteCoordinate(i, m_dstPositionX);
+    WriteCoordinate(i, m_dstPositionY);
+    i.WriteHtonU32(m_updated);
+    if (m_recoveryFlag) {
+      WriteCoordinate(i, m_recPositionX);
+      WriteCoordinate(i, m_recPositionY);
+      WriteCoordinate(i, m_prevPositionX);
+      WriteCoordinate(i, m_prevPositionY);
+      WriteCoordinate(i, m_facePositionX);
+      WriteCoordinate(i, m_facePositionY);
+      WriteCoordinate(i, m_edgeFromX);
+      WriteCoordinate(i, m_edgeFromY);
+      WriteCoordinate(i, m_edgeToX);
+      WriteCoordinate(i, m_edgeToY);
+      i.WriteHtonU16(m_perimeterHops);
+    }
+    return;
+  }
+
   i.Write((uint8_t*)&m_dstPositionX, sizeof(double));
   i.Write((uint8_t*)&m_dstPositionY, sizeof(double));
   i.Write((uint8_t*)&m_recPositionX, sizeof(double));
@@ -275,6 +573,15 @@ GpsrPositionHeader::Serialize(Buffer::Iterator i) const
 
   i.WriteHtonU32(m_updated);
   i.WriteU8(m_recoveryFlag);
+  if (m_recoveryFlag) {
+    i.Write((uint8_t*)&m_facePositionX, sizeof(double));
+    i.Write((uint8_t*)&m_facePositionY, sizeof(double));
+    i.Write((uint8_t*)&m_edgeFromX, sizeof(double));
+    i.Write((uint8_t*)&m_edgeFromY, sizeof(double));
+    i.Write((uint8_t*)&m_edgeToX, sizeof(double));
+    i.Write((uint8_t*)&m_edgeToY, sizeof(double));
+    i.WriteHtonU16(m_perimeterHops);
+  }
 }
 
 uint32_t
@@ -282,15 +589,54 @@ GpsrPositionHeader::Deserialize(Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
 
-  i.Read((uint8_t*)&m_dstPositionX, sizeof(double));
-  i.Read((uint8_t*)&m_dstPositionY, sizeof(double));
-  i.Read((uint8_t*)&m_recPositionX, sizeof(double));
-  i.Read((uint8_t*)&m_recPositionY, sizeof(double));
-  i.Read((uint8_t*)&m_prevPositionX, sizeof(double));
-  i.Read((uint8_t*)&m_prevPositionY, sizeof(double));
-
-  m_updated = i.ReadNtohU32();
-  m_recoveryFlag = i.ReadU8();
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    m_recoveryFlag = (ReadCompactFlags(i) & COMPACT_FLAG_RECOVERY) ? 1 : 0;
+    m_dstPositionX = ReadCoordinate(i);
+    m_dstPositionY = ReadCoordinate(i);
+    m_updated = i.ReadNtohU32();
+    if (m_recoveryFlag) {
+      m_recPositionX = ReadCoordinate(i);
+      m_recPositionY = ReadCoordinate(i);
+      m_prevPositionX = ReadCoordinate(i);
+      m_prevPositionY = ReadCoordinate(i);
+      m_facePositionX = ReadCoordinate(i);
+      m_facePositionY = ReadCoordinate(i);
+      m_edgeFromX = ReadCoordinate(i);
+      m_edgeFromY = ReadCoordinate(i);
+      m_edgeToX = ReadCoordinate(i);
+      m_edgeToY = ReadCoordinate(i);
+      m_perimeterHops = i.ReadNtohU16();
+    } else {
+      m_recPositionX = m_recPositionY = 0.0;
+      m_prevPositionX = m_prevPositionY = 0.0;
+      m_facePositionX = m_facePositionY = 0.0;
+      m_edgeFromX = m_edgeFromY = m_edgeToX = m_edgeToY = 0.0;
+      m_perimeterHops = 0;
+    }
+  } else {
+    i.Read((uint8_t*)&m_dstPositionX, sizeof(double));
+    i.Read((uint8_t*)&m_dstPositionY, sizeof(double));
+    i.Read((uint8_t*)&m_recPositionX, sizeof(double));
+    i.Read((uint8_t*)&m_recPositionY, sizeof(double));
+    i.Read((uint8_t*)&m_prevPositionX, sizeof(double));
+    i.Read((uint8_t*)&m_prevPositionY, sizeof(double));
+
+    m_updated = i.ReadNtohU32();
+    m_recoveryFlag = i.ReadU8();
+    if (m_recoveryFlag) {
+      i.Read((uint8_t*)&m_facePositionX, sizeof(double));
+      i.Read((uint8_t*)&m_facePositionY, sizeof(double));
+      i.Read((uint8_t*)&m_edgeFromX, sizeof(double));
+      i.Read((uint8_t*)&m_edgeFromY, sizeof(double));
+      i.Read((uint8_t*)&m_edgeToX, sizeof(double));
+      i.Read((uint8_t*)&m_edgeToY, sizeof(double));
+      m_perimeterHops = i.ReadNtohU16();
+    } else {
+      m_facePositionX = m_facePositionY = 0.0;
+      m_edgeFromX = m_edgeFromY = m_edgeToX = m_edgeToY = 0.0;
+      m_perimeterHops = 0;
+    }
+  }
 
   NS_LOG_DEBUG("Deserialize DstX " << m_dstPositionX << " DstY " << m_dstPositionY 
                  << " RecX " << m_recPositionX << " RecY " << m_recPositionY 
@@ -311,6 +657,10 @@ GpsrPositionHeader::Print(std::ostream &os) const
      << " RecY: " << m_recPositionY
      << " PrevX: " << m_prevPositionX
      << " PrevY: " << m_prevPositionY
+     << " FaceX: " << m_facePositionX
+     << " FaceY: " << m_facePositionY
+     << " FirstEdge: (" << m_edgeFromX << "," << m_edgeFromY << ")->(" << m_edgeToX << "," << m_edgeToY << ")"
+     << " PerimeterHops: " << m_perimeterHops
      << " Updated: " << m_updated
      << " Recovery: " << (m_recoveryFlag ? "true" : "false");
 }
@@ -411,6 +761,81 @@ GpsrPositionHeader::GetPrevPositionY() const
   return m_prevPositionY;
 }
 
+void
+GpsrPositionHeader::SetFacePositionX(double x)
+{
+  m_facePositionX = x;
+}
+
+double
+GpsrPositionHeader::GetFacePositionX() const
+{
+  return m_facePositionX;
+}
+
+void
+GpsrPositionHeader::SetFacePositionY(double y)
+{
+  m_facePositionY = y;
+}
+
+double
+GpsrPositionHeader::GetFacePositionY() const
+{
+  return m_facePositionY;
+}
+
+void
+GpsrPositionHeader::SetFirstEdge(Vector from, Vector to)
+{
+  m_edgeFromX = from.x;
+  m_edgeFromY = from.y;
+  m_edgeToX = to.x;
+  m_edgeToY = to.y;
+}
+
+Vector
+GpsrPositionHeader::GetFirstEdgeFrom() const
+{
+  return Vector(m_edgeFromX, m_edgeFromY, 0);
+}
+
+Vector
+GpsrPositionHeader::GetFirstEdgeTo() const
+{
+  return Vector(m_edgeToX, m_edgeToY, 0);
+}
+
+void
+GpsrPositionHeader::SetPerimeterHops(uint16_t hops)
+{
+  m_perimeterHops = hops;
+}
+
+uint16_t
+GpsrPositionHeader::GetPerimeterHops() const
+{
+  return m_perimeterHops;
+}
+
+uint32_t
+GpsrPositionHeader::PeekSerializedSize(Ptr<const Packet> p)
+{
+  GpsrPositionHeader header;
+  if (header.m_format == GPSR_FORMAT_COMPACT) {
+    // Only the recovery flag changes the compact size
+    uint8_t first = 0;
+    p->CopyData(&first, 1);
+    header.m_recoveryFlag = (first & COMPACT_FLAG_RECOVERY) ? 1 : 0;
+  } else {
+    // The raw flag follows dst, rec, prev and updated
+    uint8_t fixed[sizeof(double) * 6 + sizeof(uint32_t) + sizeof(uint8_t)];
+    p->CopyData(fixed, sizeof(fixed));
+    header.m_recoveryFlag = fixed[sizeof(fixed) - 1];
+  }
+  return header.GetSerializedSize();
+}
+
 bool
 GpsrPositionHeader::operator==(GpsrPositionHeader const & o) const
 {
@@ -421,7 +846,14 @@ GpsrPositionHeader::operator==(GpsrPositionHeader const & o) const
          m_recPositionY == o.m_recPositionY &&
          m_recoveryFlag == o.m_recoveryFlag &&
          m_prevPositionX == o.m_prevPositionX &&
-         m_prevPositionY == o.m_prevPositionY;
+         m_prevPositionY == o.m_prevPositionY &&
+         m_facePositionX == o.m_facePositionX &&
+         m_facePositionY == o.m_facePositionY &&
+         m_edgeFromX == o.m_edgeFromX &&
+         m_edgeFromY == o.m_edgeFromY &&
+         m_edgeToX == o.m_edgeToX &&
+         m_edgeToY == o.m_edgeToY &&
+         m_perimeterHops == o.m_perimeterHops;
 }
 
 std::ostream &
@@ -431,4 +863,117 @@ operator<<(std::ostream & os, GpsrPositionHeader const & h)
   return os;
 }
 
+/***************************************************
+ *            Sender Header Implementation
+ ***************************************************/
+
+NS_OBJECT_ENSURE_REGISTERED(GpsrSenderHeader);
+
+GpsrSenderHeader::GpsrSenderHeader(Ipv4Address sender, double x, double y) :
+  m_format(GetGpsrHeaderFormat()),
+  m_sender(sender),
+  m_positionX(x),
+  m_positionY(y)
+{
+}
+
+TypeId
+GpsrSenderHeader::GetTypeId()
+{
+  static TypeId tid = TypeId("ns3::GpsrSenderHeader")
+    .SetParent<Header>()
+    .SetGroupName("Gpsr")
+    .AddConstructor<GpsrSenderHeader>();
+  return tid;
+}
+
+TypeId
+GpsrSenderHeader::GetInstanceTypeId() const
+{
+  return GetTypeId();
+}
+
+uint32_t
+GpsrSenderHeader::GetSerializedSize() const
+{
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    return sizeof(uint8_t) + sizeof(uint32_t) + sizeof(int32_t) * 2;
+  }
+  return sizeof(uint32_t) + sizeof(double) * 2;
+}
+
+void
+GpsrSenderHeader::Serialize(Buffer::Iterator i) const
+{
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    i.WriteU8(COMPACT_VERSION << 4);
+    WriteTo(i, m_sender);
+    WriteCoordinate(i, m_positionX);
+    WriteCoordinate(i, m_positionY);
+    return;
+  }
+  WriteTo(i, m_sender);
+  i.Write((uint8_t*)&m_positionX, sizeof(double));
+  i.Write((uint8_t*)&m_positionY, sizeof(double));
+}
+
+uint32_t
+GpsrSenderHeader::Deserialize(Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  if (m_format == GPSR_FORMAT_COMPACT) {
+    ReadCompactFlags(i);
+    ReadFrom(i, m_sender);
+    m_positionX = ReadCoordinate(i);
+    m_positionY = ReadCoordinate(i);
+  } else {
+    ReadFrom(i, m_sender);
+    i.Read((uint8_t*)&m_positionX, sizeof(double));
+    i.Read((uint8_t*)&m_positionY, sizeof(double));
+  }
+
+  uint32_t dist = i.GetDistanceFrom(start);
+  NS_ASSERT(dist == GetSerializedSize());
+  return dist;
+}
+
+void
+GpsrSenderHeader::Print(std::ostream &os) const
+{
+  os << " Sender: " << m_sender
+     << " PositionX: " << m_positionX
+     << " PositionY: " << m_positionY;
+}
+
+Ipv4Address
+GpsrSenderHeader::GetSender() const
+{
+  return m_sender;
+}
+
+double
+GpsrSenderHeader::GetPositionX() const
+{
+  return m_positionX;
+}
+
+double
+GpsrSenderHeader::GetPositionY() const
+{
+  return m_positionY;
+}
+
+bool
+GpsrSenderHeader::operator==(GpsrSenderHeader const & o) const
+{
+  return m_sender == o.m_sender && m_positionX == o.m_positionX && m_positionY == o.m_positionY;
+}
+
+std::ostream &
+operator<<(std::ostream & os, GpsrSenderHeader const & h)
+{
+  h.Print(os);
+  return os;
+}
+
 } // namespace ns3
\ No newline at end of file
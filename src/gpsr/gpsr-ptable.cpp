@@ -1,4 +1,5 @@
 #include "gpsr/gpsr-ptable.h"
+#include "gpsr/gpsr-greedy-kernel.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include <algorithm>
@@ -10,12 +11,31 @@
 #include "ns3/double.h" // Needed for MakeTimeAccessor/Checker
 #include "ns3/uinteger.h" // Needed for MakeTimeAccessor/Checker
 #include "ns3/enum.h" // Needed for MakeTimeAccessor/Checker
+#include "ns3/boolean.h"
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE("GpsrPtable");
 NS_OBJECT_ENSURE_REGISTERED(GpsrPtable); // Ensure registered for GetTypeId
 
+// Weight of the newest sample in the link quality moving averages
+#define GPSR_LINK_ALPHA 0.25
+
+// Reception ratio assumed for a neighbor heard once
+#define GPSR_LINK_PRR_INIT 0.5
+
+// Losses counted for a single gap, older ones have decayed away anyway
+#define GPSR_LINK_MAX_MISSED 8
+
+// SNR in dB below which a link gets the smallest weight, and above which
+// it is not penalized at all
+#define GPSR_LINK_SNR_FLOOR 3.0
+#define GPSR_LINK_SNR_GOOD 15.0
+#define GPSR_LINK_SNR_MIN_WEIGHT 0.1
+
+// Quality change that invalidates cached forwarding decisions
+#define GPSR_LINK_QUALITY_STEP 0.05
+
 // Add GetTypeId method to allow configuration
 TypeId
 GpsrPtable::GetTypeId(void)
@@ -27,16 +47,379 @@ GpsrPtable::GetTypeId(void)
         .AddAttribute ("EntryLifetime", "Time after which a neighbor entry is considered expired.",
                        TimeValue (Seconds (3.0)), // Default to 3 * default HelloInterval (1s)
                        MakeTimeAccessor (&GpsrPtable::m_entryLifetime),
-                       MakeTimeChecker ());
+                       MakeTimeChecker ())
+        .AddAttribute ("Backend", "Storage layout of the neighbor entries.",
+                       EnumValue (GpsrPtable::MAP_BACKEND),
+                       MakeEnumAccessor<GpsrPtable::Backend> (&GpsrPtable::SetBackend,
+                                                              &GpsrPtable::GetBackend),
+                       MakeEnumChecker (GpsrPtable::MAP_BACKEND, "Map",
+                                        GpsrPtable::FLAT_BACKEND, "Flat"))
+        .AddAttribute ("Planarization", "Planar subgraph used by the perimeter mode.",
+                       EnumValue (GpsrPtable::PLANAR_NONE),
+                       MakeEnumAccessor<GpsrPtable::Planarization> (&GpsrPtable::SetPlanarization,
+                                                                    &GpsrPtable::GetPlanarization),
+                       MakeEnumChecker (GpsrPtable::PLANAR_NONE, "None",
+                                        GpsrPtable::PLANAR_GG, "GG",
+                                        GpsrPtable::PLANAR_RNG, "RNG"))
+        .AddAttribute ("Prediction", "Extrapolate the positions of neighbors that advertise their motion.",
+                       BooleanValue (false),
+                       MakeBooleanAccessor (&GpsrPtable::SetPrediction,
+                                            &GpsrPtable::GetPrediction),
+                       MakeBooleanChecker ())
+        .AddAttribute ("RadioRange", "Distance beyond which a predicted neighbor is out of range, 0 disables the check.",
+                       DoubleValue (250.0),
+                       MakeDoubleAccessor (&GpsrPtable::SetRadioRange,
+                                           &GpsrPtable::GetRadioRange),
+                       MakeDoubleChecker<double> (0.0))
+        .AddAttribute ("PredictedLifetime", "Time after which a predicted neighbor entry is considered expired.",
+                       TimeValue (Seconds (10.0)),
+                       MakeTimeAccessor (&GpsrPtable::SetPredictedLifetime,
+                                         &GpsrPtable::GetPredictedLifetime),
+                       MakeTimeChecker ())
+        .AddAttribute ("Metric", "Metric greedy forwarding ranks neighbors by.",
+                       EnumValue (GpsrPtable::METRIC_DISTANCE),
+                       MakeEnumAccessor<GpsrPtable::Metric> (&GpsrPtable::SetMetric,
+                                                             &GpsrPtable::GetMetric),
+                       MakeEnumChecker (GpsrPtable::METRIC_DISTANCE, "Distance",
+                                        GpsrPtable::METRIC_PRR_DISTANCE, "PrrDistance",
+                                        GpsrPtable::METRIC_ETX_PROGRESS, "EtxProgress"))
+        .AddAttribute ("LoadTolerance", "Fraction of the best score within which neighbors share greedy traffic, 0 disables spreading.",
+                       DoubleValue (0.0),
+                       MakeDoubleAccessor (&GpsrPtable::SetLoadTolerance,
+                                           &GpsrPtable::GetLoadTolerance),
+                       MakeDoubleChecker<double> (0.0, 1.0));
     return tid;
 }
 
 GpsrPtable::GpsrPtable() :
-  m_entryLifetime(Seconds(3.0)) // Default, will be overwritten by attribute if set
+  m_entryLifetime(Seconds(3.0)), // Default, will be overwritten by attribute if set
+  m_backend(MAP_BACKEND),
+  m_ringDirty(true),
+  m_planarization(PLANAR_NONE),
+  m_planarValid(false),
+  m_epoch(0),
+  m_prediction(false),
+  m_radioRange(250.0),
+  m_predictedLifetime(Seconds(10.0)),
+  m_advancedTo(-1),
+  m_rangeEpoch(0),
+  m_metric(METRIC_DISTANCE),
+  m_loadTolerance(0.0),
+  m_spreadStream(-1)
 {
   NS_LOG_FUNCTION(this << m_entryLifetime);
 }
 
+int32_t
+GpsrPtable::FindFlat(Ipv4Address id) const
+{
+  std::vector<uint32_t>::const_iterator i = std::lower_bound(m_addrs.begin(), m_addrs.end(), id.Get());
+  if (i != m_addrs.end() && *i == id.Get()) {
+    return static_cast<int32_t>(i - m_addrs.begin());
+  }
+  return -1;
+}
+
+// Visits every entry in ascending address order, whatever the backend,
+// so that ties are broken the same way by both layouts.
+template <typename F>
+void
+GpsrPtable::ForEachEntry(F f) const
+{
+  if (m_backend == FLAT_BACKEND) {
+    for (std::size_t i = 0; i < m_addrs.size(); ++i) {
+      f(Ipv4Address(m_addrs[i]), Vector(m_posX[i], m_posY[i], 0));
+    }
+    return;
+  }
+
+  for (std::map<Ipv4Address, std::pair<Vector, Time> >::const_iterator i = m_table.begin();
+       i != m_table.end(); ++i) {
+    f(i->first, i->second.first);
+  }
+}
+
+void
+GpsrPtable::SetBackend(Backend backend)
+{
+  if (backend == m_backend) {
+    return;
+  }
+
+  // Carry the current entries over to the new layout
+  std::vector<std::pair<Ipv4Address, std::pair<Vector, Time> > > entries;
+  ForEachEntry([&entries, this](Ipv4Address id, const Vector &position) {
+    entries.push_back(std::make_pair(id, std::make_pair(position, GetEntryUpdateTime(id))));
+  });
+  std::unordered_map<uint32_t, Motion> motion;
+  motion.swap(m_motion);
+  std::unordered_map<uint32_t, LinkQuality> links;
+  links.swap(m_links);
+  std::unordered_map<uint32_t, double> loads;
+  loads.swap(m_loads);
+  std::unordered_set<uint32_t> statics;
+  statics.swap(m_static);
+
+  Clear();
+  m_backend = backend;
+  m_motion.swap(motion);
+  m_links.swap(links);
+  m_loads.swap(loads);
+  m_static.swap(statics);
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    InsertEntry(entries[i].first, entries[i].second.first, entries[i].second.second);
+  }
+}
+
+GpsrPtable::Backend
+GpsrPtable::GetBackend() const
+{
+  return m_backend;
+}
+
+void
+GpsrPtable::SetPlanarization(Planarization planarization)
+{
+  if (planarization == m_planarization) {
+    return;
+  }
+  m_planarization = planarization;
+  m_planar.clear();
+  m_planarValid = false;
+  m_ringDirty = true;
+}
+
+GpsrPtable::Planarization
+GpsrPtable::GetPlanarization() const
+{
+  return m_planarization;
+}
+
+void
+GpsrPtable::SetPrediction(bool prediction)
+{
+  if (prediction == m_prediction) {
+    return;
+  }
+  m_prediction = prediction;
+  m_motion.clear();
+  m_advancedTo = -1;
+  RebuildExpiry();
+}
+
+bool
+GpsrPtable::GetPrediction() const
+{
+  return m_prediction;
+}
+
+void
+GpsrPtable::SetRadioRange(double range)
+{
+  m_radioRange = range;
+  ++m_epoch; // Forces the next range check
+}
+
+double
+GpsrPtable::GetRadioRange() const
+{
+  return m_radioRange;
+}
+
+void
+GpsrPtable::SetPredictedLifetime(Time lifetime)
+{
+  m_predictedLifetime = lifetime;
+  RebuildExpiry();
+}
+
+Time
+GpsrPtable::GetPredictedLifetime() const
+{
+  return m_predictedLifetime;
+}
+
+void
+GpsrPtable::SetMetric(Metric metric)
+{
+  if (metric != m_metric) {
+    m_metric = metric;
+    ++m_epoch;
+  }
+}
+
+GpsrPtable::Metric
+GpsrPtable::GetMetric() const
+{
+  return m_metric;
+}
+
+void
+GpsrPtable::NotifyReception(Ipv4Address id, Time expectedInterval)
+{
+  if (m_metric == METRIC_DISTANCE) {
+    return;
+  }
+
+  std::unordered_map<uint32_t, LinkQuality>::iterator i = m_links.find(id.Get());
+  if (i == m_links.end()) {
+    LinkQuality link = {GPSR_LINK_PRR_INIT, -1, 0.0, false, 1.0, false, GPSR_LINK_PRR_INIT};
+    i = m_links.insert(std::make_pair(id.Get(), link)).first;
+  }
+  LinkQuality &link = i->second;
+
+  int64_t now = Simulator::Now().GetTimeStep();
+  if (link.lastHeard >= 0) {
+    // Each full expected interval in the gap is a HELLO that did not arrive
+    int64_t expected = expectedInterval.GetTimeStep();
+    int64_t missed = expected > 0 ? (now - link.lastHeard) / expected : 0;
+    for (int64_t n = 0; n < std::min<int64_t>(missed, GPSR_LINK_MAX_MISSED); ++n) {
+      link.prr *= 1 - GPSR_LINK_ALPHA;
+    }
+    link.prr = (1 - GPSR_LINK_ALPHA) * link.prr + GPSR_LINK_ALPHA;
+  }
+  link.lastHeard = now;
+
+  PublishLinkQuality(id.Get());
+}
+
+void
+GpsrPtable::NotifySnr(Ipv4Address id, double snr)
+{
+  if (m_metric == METRIC_DISTANCE) {
+    return;
+  }
+
+  // The PHY reports a frame before it is handed up, so a neighbor's first
+  // sample arrives before its first reception
+  std::unordered_map<uint32_t, LinkQuality>::iterator i = m_links.find(id.Get());
+  if (i == m_links.end()) {
+    LinkQuality link = {GPSR_LINK_PRR_INIT, -1, snr, true, 1.0, false, GPSR_LINK_PRR_INIT};
+    m_links.insert(std::make_pair(id.Get(), link));
+    return;
+  }
+
+  LinkQuality &link = i->second;
+  link.snr = link.hasSnr ? (1 - GPSR_LINK_ALPHA) * link.snr + GPSR_LINK_ALPHA * snr : snr;
+  link.hasSnr = true;
+  PublishLinkQuality(id.Get());
+}
+
+void
+GpsrPtable::NotifyTxAttempt(Ipv4Address id, bool success)
+{
+  if (m_metric != METRIC_ETX_PROGRESS) {
+    return;
+  }
+
+  std::unordered_map<uint32_t, LinkQuality>::iterator i = m_links.find(id.Get());
+  if (i == m_links.end()) {
+    return;
+  }
+
+  LinkQuality &link = i->second;
+  double sample = success ? 1.0 : 0.0;
+  link.ackRatio = link.hasAck ? (1 - GPSR_LINK_ALPHA) * link.ackRatio + GPSR_LINK_ALPHA * sample : sample;
+  link.hasAck = true;
+  PublishLinkQuality(id.Get());
+}
+
+double
+GpsrPtable::GetLinkQuality(Ipv4Address id) const
+{
+  std::unordered_map<uint32_t, LinkQuality>::const_iterator i = m_links.find(id.Get());
+  if (i == m_links.end()) {
+    return GPSR_LINK_PRR_INIT;
+  }
+
+  const LinkQuality &link = i->second;
+  if (m_metric == METRIC_ETX_PROGRESS && link.hasAck) {
+    return link.ackRatio;
+  }
+
+  double quality = link.prr;
+  if (link.hasSnr) {
+    double weight = (link.snr - GPSR_LINK_SNR_FLOOR) / (GPSR_LINK_SNR_GOOD - GPSR_LINK_SNR_FLOOR);
+    quality *= std::min(1.0, std::max(GPSR_LINK_SNR_MIN_WEIGHT, weight));
+  }
+  return quality;
+}
+
+void
+GpsrPtable::PublishLinkQuality(uint32_t id)
+{
+  // Qualities drift with every frame; only a real change is worth
+  // invalidating the route cache for
+  double quality = GetLinkQuality(Ipv4Address(id));
+  LinkQuality &link = m_links[id];
+  if (std::fabs(quality - link.published) >= GPSR_LINK_QUALITY_STEP) {
+    link.published = quality;
+    ++m_epoch;
+  }
+}
+
+void
+GpsrPtable::SetLoadTolerance(double tolerance)
+{
+  m_loadTolerance = tolerance;
+}
+
+double
+GpsrPtable::GetLoadTolerance() const
+{
+  return m_loadTolerance;
+}
+
+void
+GpsrPtable::SetSpreadStream(int64_t stream)
+{
+  m_spreadStream = stream;
+  if (m_spreadRandom) {
+    m_spreadRandom->SetStream(stream);
+  }
+}
+
+void
+GpsrPtable::SetNeighborLoad(Ipv4Address id, double load)
+{
+  m_loads[id.Get()] = load;
+}
+
+double
+GpsrPtable::GetNeighborLoad(Ipv4Address id) const
+{
+  std::unordered_map<uint32_t, double>::const_iterator i = m_loads.find(id.Get());
+  return i == m_loads.end() ? 0.0 : i->second;
+}
+
+int64_t
+GpsrPtable::GetLifetime(uint32_t id) const
+{
+  if (m_static.find(id) != m_static.end()) {
+    // Far enough out that stamp + lifetime cannot overflow
+    return Time::Max().GetTimeStep() / 2;
+  }
+  if (m_prediction && m_motion.find(id) != m_motion.end()) {
+    return m_predictedLifetime.GetTimeStep();
+  }
+  return m_entryLifetime.GetTimeStep();
+}
+
+uint32_t
+GpsrPtable::GetSize() const
+{
+  if (m_backend == FLAT_BACKEND) {
+    return m_addrs.size();
+  }
+  return m_table.size();
+}
+
+uint64_t
+GpsrPtable::GetEpoch() const
+{
+  return m_epoch;
+}
+
 Time
 GpsrPtable::GetEntryUpdateTime(Ipv4Address id)
 {
@@ -44,6 +427,11 @@ GpsrPtable::GetEntryUpdateTime(Ipv4Address id)
     return Time(Seconds(0));
   }
 
+  if (m_backend == FLAT_BACKEND) {
+    int32_t idx = FindFlat(id);
+    return idx < 0 ? Time(Seconds(0)) : TimeStep(static_cast<uint64_t>(m_stamps[idx]));
+  }
+
   std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.find(id);
   if (i != m_table.end()) {
     return i->second.second;
@@ -55,28 +443,261 @@ GpsrPtable::GetEntryUpdateTime(Ipv4Address id)
   void
   GpsrPtable::AddEntry(Ipv4Address id, Vector position)
 {
-  std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.find(id);
-  if (i != m_table.end()) {
-    m_table.erase(id);
-  }
-
-  m_table.insert(std::make_pair(id, std::make_pair(position, Simulator::Now())));
+  m_motion.erase(id.Get());
+  InsertEntry(id, position, Simulator::Now());
 
   // Add debug message for neighbor discovery
   NS_LOG_DEBUG("Added neighbor " << id << " at position (" << position.x << "," << position.y
-                << "), table size: " << m_table.size());
+                << "), table size: " << GetSize());
+}
+
+void
+GpsrPtable::AddEntry(Ipv4Address id, Vector position, Vector velocity, Time timestamp)
+{
+  if (!m_prediction) {
+    AddEntry(id, position);
+    return;
+  }
+
+  Motion &motion = m_motion[id.Get()];
+  motion.position = position;
+  motion.velocity = velocity;
+  motion.timestamp = timestamp.GetTimeStep();
+
+  // Stored positions are extrapolated to the current time, as Advance does
+  Time now = Simulator::Now();
+  double dt = (now - timestamp).GetSeconds();
+  Vector current(position.x + velocity.x * dt, position.y + velocity.y * dt, 0);
+  InsertEntry(id, current, now);
+
+  NS_LOG_DEBUG("Added moving neighbor " << id << " at position (" << current.x << "," << current.y
+                << ") velocity (" << velocity.x << "," << velocity.y << "), table size: " << GetSize());
+}
+
+void
+GpsrPtable::AddStaticEntry(Ipv4Address id, Vector position)
+{
+  m_static.insert(id.Get());
+  AddEntry(id, position);
+}
+
+void
+GpsrPtable::InsertEntry(Ipv4Address id, Vector position, Time updated)
+{
+  bool changed = false;
+
+  if (m_backend == FLAT_BACKEND) {
+    // Keep the arrays sorted by address: updates are in place, new
+    // neighbors shift the tail by one slot
+    std::vector<uint32_t>::iterator i = std::lower_bound(m_addrs.begin(), m_addrs.end(), id.Get());
+    std::size_t idx = i - m_addrs.begin();
+    if (i == m_addrs.end() || *i != id.Get()) {
+      m_addrs.insert(i, id.Get());
+      m_posX.insert(m_posX.begin() + idx, 0.0);
+      m_posY.insert(m_posY.begin() + idx, 0.0);
+      m_stamps.insert(m_stamps.begin() + idx, 0);
+      changed = true;
+    } else if (m_posX[idx] != position.x || m_posY[idx] != position.y) {
+      changed = true;
+    }
+    m_posX[idx] = position.x;
+    m_posY[idx] = position.y;
+    m_stamps[idx] = updated.GetTimeStep();
+  } else {
+    std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.find(id);
+    if (i != m_table.end()) {
+      if (!(i->second.first == position)) {
+        changed = true;
+      }
+      m_table.erase(id);
+    } else {
+      changed = true;
+    }
+
+    m_table.insert(std::make_pair(id, std::make_pair(position, updated)));
+  }
+
+  // A new or moved neighbor changes the witness counts of its edge and of
+  // the edges it falls into
+  if (changed) {
+    ++m_epoch;
+    m_ringDirty = true;
+    if (m_planarValid) {
+      PlanarRemove(id.Get());
+      PlanarAdd(id.Get(), position);
+    }
+  }
+
+  m_expiry.push(ExpiryRecord(updated.GetTimeStep() + GetLifetime(id.Get()), id.Get()));
+
+  // Every HELLO leaves a stale record behind; keep the heap proportional to
+  // the table so it cannot grow while nobody purges
+  if (m_expiry.size() > 4 * static_cast<std::size_t>(GetSize()) + 16) {
+    RebuildExpiry();
+  }
+}
+
+void
+GpsrPtable::RebuildExpiry()
+{
+  std::vector<ExpiryRecord> records;
+  records.reserve(GetSize());
+  if (m_backend == FLAT_BACKEND) {
+    for (std::size_t i = 0; i < m_addrs.size(); ++i) {
+      records.push_back(ExpiryRecord(m_stamps[i] + GetLifetime(m_addrs[i]), m_addrs[i]));
+    }
+  } else {
+    for (std::map<Ipv4Address, std::pair<Vector, Time> >::const_iterator i = m_table.begin();
+         i != m_table.end(); ++i) {
+      records.push_back(ExpiryRecord(i->second.second.GetTimeStep() + GetLifetime(i->first.Get()),
+                                     i->first.Get()));
+    }
+  }
+
+  m_expiry = std::priority_queue<ExpiryRecord, std::vector<ExpiryRecord>, std::greater<ExpiryRecord> >(
+    std::greater<ExpiryRecord>(), std::move(records));
+}
+
+bool
+GpsrPtable::GetEntryPosition(Ipv4Address id, Vector &position) const
+{
+  if (m_backend == FLAT_BACKEND) {
+    int32_t idx = FindFlat(id);
+    if (idx < 0) {
+      return false;
+    }
+    position = Vector(m_posX[idx], m_posY[idx], 0);
+    return true;
+  }
+
+  std::map<Ipv4Address, std::pair<Vector, Time> >::const_iterator i = m_table.find(id);
+  if (i == m_table.end()) {
+    return false;
+  }
+  position = i->second.first;
+  return true;
+}
+
+void
+GpsrPtable::SetEntryPosition(Ipv4Address id, Vector position)
+{
+  if (m_backend == FLAT_BACKEND) {
+    int32_t idx = FindFlat(id);
+    if (idx < 0) {
+      return;
+    }
+    m_posX[idx] = position.x;
+    m_posY[idx] = position.y;
+  } else {
+    std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.find(id);
+    if (i == m_table.end()) {
+      return;
+    }
+    i->second.first = position;
+  }
+
+  if (m_planarValid) {
+    PlanarRemove(id.Get());
+    PlanarAdd(id.Get(), position);
+  }
+}
+
+void
+GpsrPtable::Advance(int64_t now)
+{
+  bool moved = false;
+  for (std::unordered_map<uint32_t, Motion>::const_iterator i = m_motion.begin(); i != m_motion.end(); ++i) {
+    const Motion &motion = i->second;
+    if (motion.velocity.x == 0 && motion.velocity.y == 0) {
+      continue;
+    }
+    double dt = static_cast<double>(now - motion.timestamp) / Seconds(1).GetTimeStep();
+    SetEntryPosition(Ipv4Address(i->first),
+                     Vector(motion.position.x + motion.velocity.x * dt,
+                            motion.position.y + motion.velocity.y * dt, 0));
+    moved = true;
+  }
+
+  if (moved) {
+    ++m_epoch;
+    m_ringDirty = true;
+  }
+  m_advancedTo = now;
+}
+
+void
+GpsrPtable::ExpireOutOfRange(const Vector &nodePos)
+{
+  if (!m_prediction || m_radioRange <= 0 || m_motion.empty() ||
+      (m_rangeEpoch == m_epoch && m_rangeCenter == nodePos)) {
+    return;
+  }
+
+  // GetPosition purges, which erases from m_motion, so the positions
+  // Advance stored are read directly and the deletions wait for the loop
+  std::vector<Ipv4Address> gone;
+  for (std::unordered_map<uint32_t, Motion>::const_iterator i = m_motion.begin(); i != m_motion.end(); ++i) {
+    Ipv4Address id(i->first);
+    Vector position;
+    if (GetEntryPosition(id, position) && CalculateDistance(position, nodePos) > m_radioRange) {
+      gone.push_back(id);
+    }
+  }
+  for (std::size_t i = 0; i < gone.size(); ++i) {
+    NS_LOG_DEBUG("Neighbor " << gone[i] << " is predicted out of range of " << nodePos);
+    DeleteEntry(gone[i]);
+  }
+
+  m_rangeCenter = nodePos;
+  m_rangeEpoch = m_epoch;
 }
 
 void
 GpsrPtable::DeleteEntry(Ipv4Address id)
 {
-  m_table.erase(id);
+  m_motion.erase(id.Get());
+  m_links.erase(id.Get());
+  m_loads.erase(id.Get());
+  m_static.erase(id.Get());
+  if (m_backend == FLAT_BACKEND) {
+    int32_t idx = FindFlat(id);
+    if (idx >= 0) {
+      ++m_epoch;
+      m_ringDirty = true;
+      if (m_planarValid) {
+        PlanarRemove(id.Get());
+      }
+      m_addrs.erase(m_addrs.begin() + idx);
+      m_posX.erase(m_posX.begin() + idx);
+      m_posY.erase(m_posY.begin() + idx);
+      m_stamps.erase(m_stamps.begin() + idx);
+    }
+    return;
+  }
+
+  if (m_table.erase(id) > 0) {
+    ++m_epoch;
+    m_ringDirty = true;
+    if (m_planarValid) {
+      PlanarRemove(id.Get());
+    }
+  }
 }
 
   Vector
   GpsrPtable::GetPosition(Ipv4Address id)
 {
   Purge(); // Purge expired entries before lookup
+  if (m_backend == FLAT_BACKEND) {
+    int32_t idx = FindFlat(id);
+    if (idx >= 0) {
+      NS_LOG_LOGIC("GetPosition: Found position for " << id << " in table.");
+      return Vector(m_posX[idx], m_posY[idx], 0);
+    }
+    NS_LOG_WARN("GetPosition: Could not find position for " << id << " in neighbor table.");
+    return GetInvalidPosition();
+  }
+
   std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.find(id);
   if (i != m_table.end()) {
     NS_LOG_LOGIC("GetPosition: Found position " << i->second.first << " for " << id << " in table.");
@@ -115,8 +736,14 @@ GpsrPtable::DeleteEntry(Ipv4Address id)
   bool
   GpsrPtable::IsNeighbor(Ipv4Address id)
 {
-  std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.find(id);
-  if (i != m_table.end()) {
+  bool found;
+  if (m_backend == FLAT_BACKEND) {
+    found = FindFlat(id) >= 0;
+  } else {
+    found = m_table.find(id) != m_table.end();
+  }
+
+  if (found) {
     NS_LOG_DEBUG("Found " << id << " as a neighbor");
     return true;
   }
@@ -127,26 +754,40 @@ GpsrPtable::DeleteEntry(Ipv4Address id)
   void
   GpsrPtable::Purge()
 {
-  if (m_table.empty()) {
-    return;
-  }
+  // An entry is expired once lastUpdate + lifetime <= now, so the heap is
+  // popped for as long as its earliest deadline is due
+  int64_t now = Simulator::Now().GetTimeStep();
+  uint32_t purged = 0;
 
-  std::list<Ipv4Address> toErase;
+  while (!m_expiry.empty() && m_expiry.top().first <= now) {
+    ExpiryRecord record = m_expiry.top();
+    m_expiry.pop();
+    Ipv4Address id(record.second);
 
-  std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.begin();
-  for (; i != m_table.end(); ++i) {
-    if (m_entryLifetime + i->second.second <= Simulator::Now()) {
-      NS_LOG_DEBUG("Purging expired neighbor entry for " << i->first);
-      toErase.push_back(i->first);
+    // Skip records superseded by a later update or by a deletion
+    if (m_backend == FLAT_BACKEND) {
+      int32_t idx = FindFlat(id);
+      if (idx < 0 || m_stamps[idx] + GetLifetime(record.second) != record.first) {
+        continue;
+      }
+    } else {
+      std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.find(id);
+      if (i == m_table.end() || i->second.second.GetTimeStep() + GetLifetime(record.second) != record.first) {
+        continue;
+      }
     }
+
+    NS_LOG_DEBUG("Purging expired neighbor entry for " << id);
+    DeleteEntry(id);
+    ++purged;
   }
 
-  for (std::list<Ipv4Address>::iterator it = toErase.begin(); it != toErase.end(); ++it) {
-    m_table.erase(*it);
+  if (purged > 0) {
+    NS_LOG_DEBUG("Purged " << purged << " expired neighbors, table size now: " << GetSize());
   }
 
-  if (!toErase.empty()) {
-    NS_LOG_DEBUG("Purged " << toErase.size() << " expired neighbors, table size now: " << m_table.size());
+  if (m_prediction && !m_motion.empty() && m_advancedTo != now) {
+    Advance(now);
   }
 }
 
@@ -154,41 +795,71 @@ void
 GpsrPtable::Clear()
 {
   m_table.clear();
+  m_addrs.clear();
+  m_posX.clear();
+  m_posY.clear();
+  m_stamps.clear();
+  m_expiry = std::priority_queue<ExpiryRecord, std::vector<ExpiryRecord>, std::greater<ExpiryRecord> >();
+  m_ring.clear();
+  m_ringDirty = true;
+  m_planar.clear();
+  m_planarValid = false;
+  m_motion.clear();
+  m_links.clear();
+  m_loads.clear();
+  m_static.clear();
+  ++m_epoch;
 }
 
 Ipv4Address
 GpsrPtable::BestNeighbor(Vector position, Vector nodePos)
 {
   Purge();
+  ExpireOutOfRange(nodePos);
 
   // Calculate the distance from current node to destination
   double initialDistance = CalculateDistance(nodePos, position);
 
-  if (m_table.empty()) {
+  if (GetSize() == 0) {
     NS_LOG_DEBUG("BestNeighbor table is empty - no neighbors discovered yet");
     return Ipv4Address::GetZero();
   }
 
-  // Find neighbor closest to destination
-  Ipv4Address bestFoundId = m_table.begin()->first;
-  double bestFoundDistance = CalculateDistance(m_table.begin()->second.first, position);
+  // Find neighbor closest to destination, starting from the first entry
+  Ipv4Address bestFoundId = Ipv4Address::GetZero();
+  double bestFoundDistance = 0;
+  bool first = true;
 
   NS_LOG_DEBUG("Looking for best neighbor to reach (" << position.x << "," << position.y
                 << "), my position: (" << nodePos.x << "," << nodePos.y << ")");
   NS_LOG_DEBUG("My distance to destination: " << initialDistance);
 
-  // Log all neighbors and their distances
-  for (std::map<Ipv4Address, std::pair<Vector, Time> >::iterator i = m_table.begin();
-       i != m_table.end(); ++i) {
-    double distance = CalculateDistance(i->second.first, position);
-    NS_LOG_DEBUG("  Neighbor " << i->first << " at (" << i->second.first.x << ","
-                 << i->second.first.y << "), distance: " << distance);
+  if (m_loadTolerance > 0) {
+    return SpreadNeighbor(position, nodePos);
+  }
+  if (m_metric != METRIC_DISTANCE) {
+    return BestLinkNeighbor(position, nodePos);
+  }
 
-    if (bestFoundDistance > distance) {
-      bestFoundId = i->first;
-      bestFoundDistance = distance;
-    }
-       }
+  if (m_backend == FLAT_BACKEND) {
+    // Packed coordinates: vectorized argmin over squared distances
+    std::size_t idx = GpsrGreedyKernel::ArgMin(m_posX.data(), m_posY.data(), m_addrs.size(),
+                                               position.x, position.y, position.z, bestFoundDistance);
+    bestFoundId = Ipv4Address(m_addrs[idx]);
+  } else {
+    // Log all neighbors and their distances
+    ForEachEntry([&](Ipv4Address id, const Vector &neighborPos) {
+      double distance = CalculateDistance(neighborPos, position);
+      NS_LOG_DEBUG("  Neighbor " << id << " at (" << neighborPos.x << ","
+                   << neighborPos.y << "), distance: " << distance);
+
+      if (first || bestFoundDistance > distance) {
+        bestFoundId = id;
+        bestFoundDistance = distance;
+        first = false;
+      }
+    });
+  }
 
   // Only return neighbor if it's closer to destination than current node
   if (initialDistance > bestFoundDistance) {
@@ -201,24 +872,116 @@ GpsrPtable::BestNeighbor(Vector position, Vector nodePos)
   }
 }
 
+Ipv4Address
+GpsrPtable::BestLinkNeighbor(const Vector &position, const Vector &nodePos) const
+{
+  // Progress times the chance the frame gets through. For ETX that is the
+  // inverse of transmissions per metre, so both metrics maximize it.
+  double initialDistance = CalculateDistance(nodePos, position);
+  Ipv4Address bestFoundId = Ipv4Address::GetZero();
+  double bestFoundScore = 0;
+
+  ForEachEntry([&](Ipv4Address id, const Vector &neighborPos) {
+    double progress = initialDistance - CalculateDistance(neighborPos, position);
+    if (progress <= 0) {
+      return;
+    }
+    double score = GetScore(id, progress);
+    NS_LOG_DEBUG("  Neighbor " << id << " progress: " << progress << ", quality: " << GetLinkQuality(id));
+    if (score > bestFoundScore) {
+      bestFoundId = id;
+      bestFoundScore = score;
+    }
+  });
+
+  if (bestFoundId == Ipv4Address::GetZero()) {
+    NS_LOG_DEBUG("No neighbor makes progress towards the destination");
+  } else {
+    NS_LOG_DEBUG("Selected neighbor " << bestFoundId << " with score " << bestFoundScore);
+  }
+  return bestFoundId;
+}
+
+Ipv4Address
+GpsrPtable::SpreadNeighbor(const Vector &position, const Vector &nodePos)
+{
+  double initialDistance = CalculateDistance(nodePos, position);
+  std::vector<std::pair<Ipv4Address, double> > candidates;
+  double bestScore = 0;
+  ForEachEntry([&](Ipv4Address id, const Vector &neighborPos) {
+    double progress = initialDistance - CalculateDistance(neighborPos, position);
+    if (progress > 0) {
+      double score = GetScore(id, progress);
+      candidates.push_back(std::make_pair(id, score));
+      bestScore = std::max(bestScore, score);
+    }
+  });
+  if (bestScore <= 0) {
+    NS_LOG_DEBUG("No neighbor makes progress towards the destination");
+    return Ipv4Address::GetZero();
+  }
+
+  // Near-best neighbors weighted by the capacity they advertise as left;
+  // if all of them are saturated the best one is as good as any
+  Ipv4Address bestFoundId = Ipv4Address::GetZero();
+  double total = 0;
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    if (candidates[i].second < (1 - m_loadTolerance) * bestScore) {
+      continue;
+    }
+    if (candidates[i].second == bestScore && bestFoundId == Ipv4Address::GetZero()) {
+      bestFoundId = candidates[i].first;
+    }
+    candidates[i].second *= 1 - GetNeighborLoad(candidates[i].first);
+    total += candidates[i].second;
+    candidates[kept++] = candidates[i];
+  }
+  if (total <= 0) {
+    return bestFoundId;
+  }
+
+  if (!m_spreadRandom) {
+    m_spreadRandom = CreateObject<UniformRandomVariable>();
+    if (m_spreadStream >= 0) {
+      m_spreadRandom->SetStream(m_spreadStream);
+    }
+  }
+  double draw = m_spreadRandom->GetValue(0, total);
+  for (std::size_t i = 0; i < kept; ++i) {
+    draw -= candidates[i].second;
+    if (draw < 0) {
+      NS_LOG_DEBUG("Spread to neighbor " << candidates[i].first << " among " << kept << " candidates");
+      return candidates[i].first;
+    }
+  }
+  return candidates[kept - 1].first;
+}
+
+double
+GpsrPtable::GetScore(Ipv4Address id, double progress) const
+{
+  return m_metric == METRIC_DISTANCE ? progress : progress * GetLinkQuality(id);
+}
+
 Ipv4Address
 GpsrPtable::BestAngle(Vector dstPos, Vector recPos, Vector myPos, Vector prevPos)
 {
   Purge();
+  ExpireOutOfRange(myPos);
   NS_LOG_FUNCTION(this << " Dst:" << dstPos << " Rec:" << recPos << " My:" << myPos << " Prev:" << prevPos);
 
-  if (m_table.empty()) {
+  if (GetSize() == 0) {
     NS_LOG_DEBUG("BestAngle: Neighbor table empty at " << myPos);
     return Ipv4Address::GetZero();
   }
 
   // Debug: Log neighbor table contents
-  NS_LOG_DEBUG("BestAngle: Current Neighbors at " << myPos << " (Table size: " << m_table.size() << "):");
-  for (std::map<Ipv4Address, std::pair<Vector, Time> >::const_iterator dbg_it = m_table.begin(); 
-       dbg_it != m_table.end(); ++dbg_it) {
-      NS_LOG_DEBUG("  -> " << dbg_it->first << " at " << dbg_it->second.first 
-                   << " (Updated: " << dbg_it->second.second.GetSeconds() << "s)");
-  }
+  NS_LOG_DEBUG("BestAngle: Current Neighbors at " << myPos << " (Table size: " << GetSize() << "):");
+  ForEachEntry([this](Ipv4Address id, const Vector &neighborPos) {
+      NS_LOG_DEBUG("  -> " << id << " at " << neighborPos
+                   << " (Updated: " << GetEntryUpdateTime(id).GetSeconds() << "s)");
+  });
   // End Debug Log
 
   if (prevPos == GetInvalidPosition()) {
@@ -227,45 +990,181 @@ GpsrPtable::BestAngle(Vector dstPos, Vector recPos, Vector myPos, Vector prevPos
   }
 
 
-  Ipv4Address bestFoundId = Ipv4Address::GetZero();
-  double smallestAngle = 361.0; // Initialize with value > 360
+  if (m_planarization != PLANAR_NONE && (!m_planarValid || !(m_planarCenter == myPos))) {
+    RebuildPlanar(myPos);
+  }
+  if (m_ringDirty || !(m_ringCenter == myPos)) {
+    RebuildRing(myPos);
+  }
 
   NS_LOG_DEBUG("BestAngle: Evaluating neighbors relative to edge " << prevPos << " -> " << myPos);
 
-  for (std::map<Ipv4Address, std::pair<Vector, Time> >::const_iterator i = m_table.begin();
-       i != m_table.end(); ++i) 
-  {
-    Vector neighborPos = i->second.first;
-    Ipv4Address neighborId = i->first;
-
-    if (neighborPos == prevPos) {
-        NS_LOG_LOGIC("BestAngle: Skipping neighbor " << neighborId << " at previous hop position " << prevPos);
-        continue;
-    }
+  // First neighbor strictly counter-clockwise of the previous hop, wrapping
+  // around. Neighbors on the previous hop's bearing are reached last, which
+  // matches GetAngle() mapping a zero angle to 360 degrees.
+  double prevBearing = PseudoAngle(prevPos.x - myPos.x, prevPos.y - myPos.y);
+  std::vector<RingEntry>::const_iterator start =
+    std::upper_bound(m_ring.begin(), m_ring.end(), prevBearing,
+                     [](double bearing, const RingEntry &e) { return bearing < e.bearing; });
 
-    double angle = GetAngle(myPos, prevPos, neighborPos);
-    // Debug: Log calculated angle
-    NS_LOG_DEBUG("BestAngle:  Neighbor " << neighborId << " at " << neighborPos << ", Angle = " << angle);
-
-    // TODO: Implement check against recPos-dstPos line intersection here? 
-
-    if (angle < smallestAngle) {
-      // Debug: Log potential new best angle
-      NS_LOG_DEBUG("BestAngle:   New smallest angle found: " << angle << " for neighbor " << neighborId);
-      smallestAngle = angle;
-      bestFoundId = neighborId;
+  Ipv4Address bestFoundId = Ipv4Address::GetZero();
+  Vector bestFoundPos;
+  for (std::size_t n = 0; n < m_ring.size(); ++n) {
+    std::size_t k = (start - m_ring.begin() + n) % m_ring.size();
+    if (m_ring[k].position == prevPos) {
+      NS_LOG_LOGIC("BestAngle: Skipping neighbor " << Ipv4Address(m_ring[k].address)
+                   << " at previous hop position " << prevPos);
+      continue;
     }
+    bestFoundId = Ipv4Address(m_ring[k].address);
+    bestFoundPos = m_ring[k].position;
+    break;
   }
 
   if (bestFoundId == Ipv4Address::GetZero()){
       NS_LOG_DEBUG("BestAngle: No suitable neighbor found according to right-hand rule.");
   } else {
-      NS_LOG_DEBUG("BestAngle: Selected neighbor " << bestFoundId << " with angle " << smallestAngle);
+      NS_LOG_DEBUG("BestAngle: Selected neighbor " << bestFoundId << " with angle "
+                   << GetAngle(myPos, prevPos, bestFoundPos));
   }
 
   return bestFoundId;
 }
 
+void
+GpsrPtable::RebuildRing(const Vector &center)
+{
+  m_ring.clear();
+  m_ring.reserve(GetSize());
+  ForEachEntry([this, &center](Ipv4Address id, const Vector &position) {
+    if (m_planarization != PLANAR_NONE && m_planar[id.Get()].witnesses > 0) {
+      return; // Edge removed by the planarization
+    }
+    RingEntry e;
+    e.bearing = PseudoAngle(position.x - center.x, position.y - center.y);
+    e.address = id.Get();
+    e.position = position;
+    m_ring.push_back(e);
+  });
+
+  // Entries arrive in address order, so a stable sort keeps equal bearings
+  // ordered by address
+  std::stable_sort(m_ring.begin(), m_ring.end(),
+                   [](const RingEntry &a, const RingEntry &b) { return a.bearing < b.bearing; });
+  m_ringCenter = center;
+  m_ringDirty = false;
+}
+
+bool
+GpsrPtable::IsWitness(const Vector &center, const Vector &v, const Vector &w) const
+{
+  double dx = v.x - center.x;
+  double dy = v.y - center.y;
+  double uv = dx * dx + dy * dy;
+  dx = w.x - center.x;
+  dy = w.y - center.y;
+  double uw = dx * dx + dy * dy;
+  dx = w.x - v.x;
+  dy = w.y - v.y;
+  double vw = dx * dx + dy * dy;
+
+  if (m_planarization == PLANAR_GG) {
+    // w strictly inside the circle with diameter center-v
+    return uw + vw < uv;
+  }
+  // w strictly inside the lune of center-v
+  return std::max(uw, vw) < uv;
+}
+
+void
+GpsrPtable::RebuildPlanar(const Vector &center)
+{
+  NS_LOG_FUNCTION(this << center);
+  m_planar.clear();
+  m_planarCenter = center;
+  ForEachEntry([this](Ipv4Address id, const Vector &position) {
+    PlanarAdd(id.Get(), position);
+  });
+  m_planarValid = true;
+  m_ringDirty = true;
+}
+
+void
+GpsrPtable::PlanarAdd(uint32_t id, const Vector &position)
+{
+  uint32_t witnesses = 0;
+  for (std::unordered_map<uint32_t, PlanarEntry>::iterator i = m_planar.begin(); i != m_planar.end(); ++i) {
+    if (i->first == id) {
+      continue;
+    }
+    if (IsWitness(m_planarCenter, i->second.position, position)) {
+      ++i->second.witnesses;
+    }
+    if (IsWitness(m_planarCenter, position, i->second.position)) {
+      ++witnesses;
+    }
+  }
+
+  PlanarEntry &entry = m_planar[id];
+  entry.position = position;
+  entry.witnesses = witnesses;
+}
+
+void
+GpsrPtable::PlanarRemove(uint32_t id)
+{
+  std::unordered_map<uint32_t, PlanarEntry>::iterator found = m_planar.find(id);
+  if (found == m_planar.end()) {
+    return;
+  }
+  Vector position = found->second.position;
+  m_planar.erase(found);
+
+  for (std::unordered_map<uint32_t, PlanarEntry>::iterator i = m_planar.begin(); i != m_planar.end(); ++i) {
+    if (IsWitness(m_planarCenter, i->second.position, position)) {
+      --i->second.witnesses;
+    }
+  }
+}
+
+bool
+GpsrPtable::SegmentIntersection(Vector a1, Vector a2, Vector b1, Vector b2, Vector &cross)
+{
+  double ax = a2.x - a1.x;
+  double ay = a2.y - a1.y;
+  double bx = b2.x - b1.x;
+  double by = b2.y - b1.y;
+  double denom = ax * by - ay * bx;
+  if (denom == 0) {
+    return false; // Parallel or degenerate
+  }
+
+  double cx = b1.x - a1.x;
+  double cy = b1.y - a1.y;
+  double t = (cx * by - cy * bx) / denom;
+  double u = (cx * ay - cy * ax) / denom;
+  if (t < 0 || t > 1 || u < 0 || u > 1) {
+    return false;
+  }
+
+  cross = Vector(a1.x + t * ax, a1.y + t * ay, 0);
+  return true;
+}
+
+// Diamond angle: walks the unit diamond instead of the unit circle, so it
+// orders directions like atan2 without any trigonometry
+double
+GpsrPtable::PseudoAngle(double dx, double dy)
+{
+  if (dx == 0 && dy == 0) {
+    return 0; // atan2(0, 0) == 0
+  }
+  if (dy >= 0) {
+    return dx >= 0 ? dy / (dx + dy) : 1 - dx / (dy - dx);
+  }
+  return dx < 0 ? 2 - dy / (-dx - dy) : 3 + dx / (dx - dy);
+}
+
 // GetAngle calculates the counter-clockwise angle (0-360) from vector Center->RefPos
 // to vector Center->NodePos using atan2
 double
@@ -1,6 +1,5 @@
 #include "gpsr/gpsr-rqueue.h"
-#include <algorithm>
-#include <functional>
+#include <iterator>
 #include "ns3/ipv4-route.h"
 #include "ns3/socket.h"
 #include "ns3/log.h"
@@ -99,56 +98,83 @@ GpsrQueueEntry::GetExpireTime() const
 
 GpsrRqueue::GpsrRqueue(uint32_t maxLen, Time timeout) :
   m_maxLen(maxLen),
-  m_queueTimeout(timeout)
+  m_queueTimeout(timeout),
+  m_expired(0),
+  m_delivered(0),
+  m_dropped(0)
 {
 }
 
+GpsrRqueue::~GpsrRqueue()
+{
+  m_expiryEvent.Cancel();
+}
+
 bool
 GpsrRqueue::IsEmpty() const
 {
   return m_queue.empty();
 }
 
+GpsrRqueue::DuplicateKey
+GpsrRqueue::MakeKey(const Ipv4Header &header)
+{
+  DuplicateKey key;
+  key.src = header.GetSource().Get();
+  key.dst = header.GetDestination().Get();
+  key.protocol = header.GetProtocol();
+  key.id = header.GetIdentification();
+  return key;
+}
+
+void
+GpsrRqueue::Remove(EntryList::iterator i)
+{
+  uint32_t dst = i->GetIpv4Header().GetDestination().Get();
+  std::unordered_map<uint32_t, std::deque<EntryList::iterator> >::iterator fifo = m_byDst.find(dst);
+  NS_ASSERT(fifo != m_byDst.end() && fifo->second.front() == i);
+  fifo->second.pop_front();
+  if (fifo->second.empty()) {
+    m_byDst.erase(fifo);
+  }
+
+  m_keys.erase(MakeKey(i->GetIpv4Header()));
+  m_queue.erase(i);
+}
+
 bool
 GpsrRqueue::Enqueue(GpsrQueueEntry & entry)
 {
   Purge();
 
-  // Check if an identical packet (based on IP header) is already in the queue
+  // Check if an identical packet (based on IP header) is already in the queue.
+  // Key IP fields: Source, Destination, Protocol, Identification
+  // Note: Assumes fragmentation is not a primary concern here or is handled elsewhere.
   const Ipv4Header& newHeader = entry.GetIpv4Header();
-  for (std::vector<GpsrQueueEntry>::const_iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
-    const Ipv4Header& existingHeader = i->GetIpv4Header();
-    // Check key IP fields: Source, Destination, Protocol, Identification
-    // Note: Assumes fragmentation is not a primary concern here or is handled elsewhere.
-    if (existingHeader.GetSource() == newHeader.GetSource() &&
-        existingHeader.GetDestination() == newHeader.GetDestination() &&
-        existingHeader.GetProtocol() == newHeader.GetProtocol() &&
-        existingHeader.GetIdentification() == newHeader.GetIdentification())
-    {
-        NS_LOG_LOGIC("Duplicate packet detected based on IP header fields (Src=" << newHeader.GetSource()
-                     << ", Dst=" << newHeader.GetDestination() << ", Id=" << newHeader.GetIdentification()
-                     << "). Packet UID " << entry.GetPacket()->GetUid() << " not enqueued.");
-        return false; // Drop duplicate
-    }
-    /* Original check using GetUid:
-    if (i->GetPacket()->GetUid() == entry.GetPacket()->GetUid() &&
-        i->GetIpv4Header().GetDestination() == entry.GetIpv4Header().GetDestination()) {
-      return false;
-    }
-    */
+  DuplicateKey key = MakeKey(newHeader);
+  if (m_keys.find(key) != m_keys.end()) {
+    NS_LOG_LOGIC("Duplicate packet detected based on IP header fields (Src=" << newHeader.GetSource()
+                 << ", Dst=" << newHeader.GetDestination() << ", Id=" << newHeader.GetIdentification()
+                 << "). Packet UID " << entry.GetPacket()->GetUid() << " not enqueued.");
+    return false; // Drop duplicate
   }
 
   // Set timeout for the entry
   entry.SetExpireTime(m_queueTimeout);
 
-  // If queue full, drop the oldest packet
-  if (m_queue.size() == m_maxLen) {
+  // If queue full, drop the oldest packet. It is also the oldest of its
+  // destination, so it sits at the front of that FIFO.
+  while (!m_queue.empty() && m_queue.size() >= m_maxLen) {
     Drop(m_queue.front(), "Drop the most aged packet");
-    m_queue.erase(m_queue.begin());
+    Remove(m_queue.begin());
+    m_dropped++;
   }
 
   // Add new packet to queue
   m_queue.push_back(entry);
+  m_byDst[newHeader.GetDestination().Get()].push_back(std::prev(m_queue.end()));
+  m_keys.insert(key);
+  ScheduleExpiry();
   return true;
 }
 
@@ -157,27 +183,23 @@ GpsrRqueue::Dequeue(Ipv4Address dst, GpsrQueueEntry & entry)
 {
   Purge();
 
-  for (std::vector<GpsrQueueEntry>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
-    if (i->GetIpv4Header().GetDestination() == dst) {
-      entry = *i;
-      m_queue.erase(i);
-      return true;
-    }
+  std::unordered_map<uint32_t, std::deque<EntryList::iterator> >::iterator fifo = m_byDst.find(dst.Get());
+  if (fifo == m_byDst.end()) {
+    return false;
   }
 
-  return false;
+  EntryList::iterator i = fifo->second.front();
+  entry = *i;
+  Remove(i);
+  m_delivered++;
+  ScheduleExpiry();
+  return true;
 }
 
 bool
 GpsrRqueue::Find(Ipv4Address dst)
 {
-  for (std::vector<GpsrQueueEntry>::const_iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
-    if (i->GetIpv4Header().GetDestination() == dst) {
-      return true;
-    }
-  }
-
-  return false;
+  return m_byDst.find(dst.Get()) != m_byDst.end();
 }
 
 uint32_t
@@ -194,14 +216,18 @@ GpsrRqueue::DropPacketWithDst(Ipv4Address dst)
   Purge();
 
   // Drop all packets with this destination
-  for (std::vector<GpsrQueueEntry>::iterator i = m_queue.begin(); i != m_queue.end();) {
-    if (i->GetIpv4Header().GetDestination() == dst) {
-      Drop(*i, "DropPacketWithDst");
-      i = m_queue.erase(i);
-    } else {
-      ++i;
+  std::unordered_map<uint32_t, std::deque<EntryList::iterator> >::iterator fifo = m_byDst.find(dst.Get());
+  while (fifo != m_byDst.end()) {
+    EntryList::iterator i = fifo->second.front();
+    Drop(*i, "DropPacketWithDst");
+    bool last = fifo->second.size() == 1;
+    Remove(i);
+    m_dropped++;
+    if (last) {
+      break;
     }
   }
+  ScheduleExpiry();
 }
 
 void
@@ -228,31 +254,71 @@ GpsrRqueue::GetQueueTimeout() const
   return m_queueTimeout;
 }
 
+uint32_t
+GpsrRqueue::GetExpiredCount() const
+{
+  return m_expired;
+}
+
+uint32_t
+GpsrRqueue::GetDeliveredCount() const
+{
+  return m_delivered;
+}
+
+uint32_t
+GpsrRqueue::GetDroppedCount() const
+{
+  return m_dropped;
+}
+
 void
 GpsrRqueue::Purge()
 {
-  // Remove all expired entries
-  for (std::vector<GpsrQueueEntry>::iterator i = m_queue.begin(); i != m_queue.end();) {
-    if (i->GetExpireTime() < Seconds(0)) {
-      Drop(*i, "Drop outdated packet");
-      i = m_queue.erase(i);
-    } else {
-      ++i;
-    }
+  // Entries are in expiry order, so stop at the first one still alive.
+  // An entry is due at its deadline, matching when Expire() runs; a caller
+  // scheduled at the same instant may run before the event and must not
+  // see it either.
+  while (!m_queue.empty() && m_queue.front().GetExpireTime() <= Seconds(0)) {
+    Drop(m_queue.front(), "Drop outdated packet");
+    Remove(m_queue.begin());
+    m_expired++;
   }
 }
 
 void
-GpsrRqueue::Drop(GpsrQueueEntry en, std::string reason)
+GpsrRqueue::ScheduleExpiry()
 {
-  NS_LOG_LOGIC(reason << en.GetPacket()->GetUid() << " " << en.GetIpv4Header().GetDestination());
-  en.GetErrorCallback()(en.GetPacket(), en.GetIpv4Header(), Socket::ERROR_NOROUTETOHOST);
+  if (m_queue.empty()) {
+    m_expiryEvent.Cancel();
+    return;
+  }
+
+  // Only the front can change the earliest deadline, so this is a no-op
+  // for enqueues behind it
+  Time delay = m_queue.front().GetExpireTime();
+  Time at = Simulator::Now() + delay;
+  if (m_expiryEvent.IsPending() && m_expiryAt == at) {
+    return;
+  }
+  m_expiryEvent.Cancel();
+  m_expiryAt = at;
+  m_expiryEvent = Simulator::Schedule(delay, &GpsrRqueue::Expire, this);
 }
 
-bool
-GpsrRqueue::IsEqual(GpsrQueueEntry entry, const Ipv4Address dst)
+void
+GpsrRqueue::Expire()
+{
+  NS_LOG_FUNCTION(this);
+  Purge();
+  ScheduleExpiry();
+}
+
+void
+GpsrRqueue::Drop(GpsrQueueEntry en, std::string reason)
 {
-  return entry.GetIpv4Header().GetDestination() == dst;
+  NS_LOG_LOGIC(reason << en.GetPacket()->GetUid() << " " << en.GetIpv4Header().GetDestination());
+  en.GetErrorCallback()(en.GetPacket(), en.GetIpv4Header(), Socket::ERROR_NOROUTETOHOST);
 }
 
 } // namespace ns3
\ No newline at end of file
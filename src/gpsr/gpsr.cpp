@@ -7,12 +7,20 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/wifi-net-device.h"
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <limits>
 #include "ns3/wifi-mac.h"        // For WifiMac (was forward-declared but needs full definition)
-#include "ns3/node-list.h"      // Added for NodeList access
+#include "gpsr/gpsr-location.h"
 #include "ns3/arp-cache.h"      // Added for ArpCache access
 #include "ns3/loopback-net-device.h" // Added for LoopbackNetDevice type
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/llc-snap-header.h"
+#include "ns3/wifi-remote-station-manager.h"
+#include "ns3/simulation-singleton.h"
+#include "gpsr/gpsr-beacon.h"
 
 namespace ns3 {
 
@@ -24,6 +32,23 @@ const uint32_t Gpsr::GPSR_PORT = 666;
 // Maximum allowed jitter for hello messages
 #define GPSR_MAX_JITTER (m_helloInterval.GetSeconds() / 2)
 
+// UDP and IPv4 header bytes in front of every HELLO
+#define GPSR_HELLO_OVERHEAD 28
+
+// Greedy route cache entries kept before the cache is flushed
+#define GPSR_ROUTE_CACHE_MAX 1024
+
+// Positions closer than this are the same node, the compact header format
+// rounds coordinates to millimetres
+#define GPSR_POSITION_EPSILON 0.01
+
+// Weight of the newest queue occupancy sample in the advertised load
+#define GPSR_LOAD_ALPHA 0.125
+
+// Load spreading draws from the node's stream plus this, so that it does
+// not replay the jitter of another node
+#define GPSR_SPREAD_STREAM_OFFSET 65536
+
 /**
  * \brief Tag for deferred route requests
  */
@@ -52,6 +77,123 @@ public:
   uint32_t m_isCallFromL3;
 };
 
+/**
+ * \brief Marks a data frame whose IP payload starts with a GpsrSenderHeader
+ *
+ * Same stand-in as GpsrPositionTag below. When both are present the sender
+ * header comes first.
+ */
+class GpsrSenderTag : public Tag
+{
+public:
+  GpsrSenderTag() : Tag() {}
+
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::GpsrSenderTag").SetParent<Tag>();
+    return tid;
+  }
+
+  TypeId GetInstanceTypeId() const { return GetTypeId(); }
+
+  uint32_t GetSerializedSize() const { return 0; }
+
+  void Serialize(TagBuffer i) const {}
+
+  void Deserialize(TagBuffer i) {}
+
+  void Print(std::ostream &os) const {
+    os << "GpsrSenderTag";
+  }
+};
+
+/**
+ * \brief Marks a data packet whose IP payload starts with a GpsrPositionHeader
+ *
+ * Stands in for the bit a real deployment would carry in the IP header
+ * (protocol number or option), so that packets without a position header
+ * are never misparsed. It has no payload and adds nothing on the air.
+ */
+class GpsrPositionTag : public Tag
+{
+public:
+  GpsrPositionTag() : Tag() {}
+
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::GpsrPositionTag").SetParent<Tag>();
+    return tid;
+  }
+
+  TypeId GetInstanceTypeId() const { return GetTypeId(); }
+
+  uint32_t GetSerializedSize() const { return 0; }
+
+  void Serialize(TagBuffer i) const {}
+
+  void Deserialize(TagBuffer i) {}
+
+  void Print(std::ostream &os) const {
+    os << "GpsrPositionTag";
+  }
+};
+
+/**
+ * \brief Greedy hops, perimeter hops and mode switches of one data packet
+ *
+ * Counted at every hop and read where the packet is delivered, so that
+ * path statistics are per packet rather than per forwarding node. Packets
+ * start in greedy mode, so a first hop on the perimeter is a switch.
+ */
+class GpsrHopsTag : public Tag
+{
+public:
+  GpsrHopsTag() : Tag(), m_greedy(0), m_perimeter(0), m_switches(0), m_onPerimeter(0) {}
+
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::GpsrHopsTag").SetParent<Tag>();
+    return tid;
+  }
+
+  TypeId GetInstanceTypeId() const { return GetTypeId(); }
+
+  uint32_t GetSerializedSize() const { return sizeof(uint16_t) * 3 + sizeof(uint8_t); }
+
+  void Serialize(TagBuffer i) const {
+    i.WriteU16(m_greedy);
+    i.WriteU16(m_perimeter);
+    i.WriteU16(m_switches);
+    i.WriteU8(m_onPerimeter);
+  }
+
+  void Deserialize(TagBuffer i) {
+    m_greedy = i.ReadU16();
+    m_perimeter = i.ReadU16();
+    m_switches = i.ReadU16();
+    m_onPerimeter = i.ReadU8();
+  }
+
+  void Print(std::ostream &os) const {
+    os << "GpsrHopsTag: " << m_greedy << " greedy, " << m_perimeter << " perimeter, "
+       << m_switches << " switches";
+  }
+
+  void CountHop(bool perimeter) {
+    if (perimeter != (m_onPerimeter != 0)) {
+      ++m_switches;
+      m_onPerimeter = perimeter ? 1 : 0;
+    }
+    if (perimeter) {
+      ++m_perimeter;
+    } else {
+      ++m_greedy;
+    }
+  }
+
+  uint16_t m_greedy;
+  uint16_t m_perimeter;
+  uint16_t m_switches;
+  uint8_t m_onPerimeter;  // Mode of the last hop
+};
+
 NS_OBJECT_ENSURE_REGISTERED(Gpsr);
 
   TypeId
@@ -76,17 +218,176 @@ NS_OBJECT_ENSURE_REGISTERED(Gpsr);
       .AddAttribute("PerimeterMode", "Enable perimeter mode for recovery",
                    BooleanValue(true),
                    MakeBooleanAccessor(&Gpsr::m_perimeterMode),
-                   MakeBooleanChecker());
+                   MakeBooleanChecker())
+      .AddAttribute("NeighborTableBackend", "Storage layout of the neighbor position table",
+                   EnumValue(GpsrPtable::MAP_BACKEND),
+                   MakeEnumAccessor<GpsrPtable::Backend>(&Gpsr::SetNeighborTableBackend,
+                                                         &Gpsr::GetNeighborTableBackend),
+                   MakeEnumChecker(GpsrPtable::MAP_BACKEND, "Map",
+                                   GpsrPtable::FLAT_BACKEND, "Flat"))
+      .AddAttribute("Planarization", "Planar subgraph of the neighbor table used in perimeter mode",
+                   EnumValue(GpsrPtable::PLANAR_NONE),
+                   MakeEnumAccessor<GpsrPtable::Planarization>(&Gpsr::SetPlanarization,
+                                                               &Gpsr::GetPlanarization),
+                   MakeEnumChecker(GpsrPtable::PLANAR_NONE, "None",
+                                   GpsrPtable::PLANAR_GG, "GG",
+                                   GpsrPtable::PLANAR_RNG, "RNG"))
+      .AddAttribute("DataHeader", "Position header carried by data packets in greedy mode",
+                   EnumValue(Gpsr::DATA_HEADER_FULL),
+                   MakeEnumAccessor<Gpsr::DataHeaderMode>(&Gpsr::m_dataHeaderMode),
+                   MakeEnumChecker(Gpsr::DATA_HEADER_FULL, "Full",
+                                   Gpsr::DATA_HEADER_STUB, "Stub",
+                                   Gpsr::DATA_HEADER_NONE, "None"))
+      .AddAttribute("RouteCacheBucket",
+                   "Side in metres of the buckets within which a cached greedy route is reused for a moved "
+                   "destination, 0 reuses it only for the exact position it was chosen for",
+                   DoubleValue(0.0),
+                   MakeDoubleAccessor(&Gpsr::m_routeCacheBucket),
+                   MakeDoubleChecker<double>(0.0))
+      .AddAttribute("HelloMode", "When HELLO beacons are sent",
+                   EnumValue(Gpsr::HELLO_FIXED),
+                   MakeEnumAccessor<Gpsr::HelloMode>(&Gpsr::m_helloMode),
+                   MakeEnumChecker(Gpsr::HELLO_FIXED, "Fixed",
+                                   Gpsr::HELLO_ADAPTIVE, "Adaptive",
+                                   Gpsr::HELLO_OFF, "Off"))
+      .AddAttribute("HelloDistance", "Distance in metres a node moves before it sends an adaptive HELLO",
+                   DoubleValue(10.0),
+                   MakeDoubleAccessor(&Gpsr::m_helloDistance),
+                   MakeDoubleChecker<double>(0.0))
+      .AddAttribute("MinHelloInterval", "Minimum time between adaptive HELLOs",
+                   TimeValue(Seconds(0.25)),
+                   MakeTimeAccessor(&Gpsr::m_minHelloInterval),
+                   MakeTimeChecker())
+      .AddAttribute("MaxHelloInterval", "Maximum time between adaptive HELLOs, keeps neighbor entries alive",
+                   TimeValue(Seconds(2.5)),
+                   MakeTimeAccessor(&Gpsr::m_maxHelloInterval),
+                   MakeTimeChecker())
+      .AddAttribute("BeaconSlot", "Slot HELLOs are rounded up to in a calendar shared by all nodes, 0 for a timer per node",
+                   TimeValue(Seconds(0)),
+                   MakeTimeAccessor(&Gpsr::m_beaconSlot),
+                   MakeTimeChecker(Seconds(0)))
+      .AddAttribute("HelloMotion", "HELLOs carry the sender's velocity and the time its position was sampled",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&Gpsr::m_helloMotion),
+                   MakeBooleanChecker())
+      .AddAttribute("PositionPrediction", "Extrapolate the positions of neighbors that advertise their motion",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&Gpsr::SetPositionPrediction,
+                                       &Gpsr::GetPositionPrediction),
+                   MakeBooleanChecker())
+      .AddAttribute("RadioRange", "Distance in metres beyond which a predicted neighbor is dropped, 0 disables it",
+                   DoubleValue(250.0),
+                   MakeDoubleAccessor(&Gpsr::SetRadioRange,
+                                      &Gpsr::GetRadioRange),
+                   MakeDoubleChecker<double>(0.0))
+      .AddAttribute("PredictedEntryLifetime", "Lifetime of neighbor entries whose position is predicted",
+                   TimeValue(Seconds(10.0)),
+                   MakeTimeAccessor(&Gpsr::SetPredictedEntryLifetime,
+                                    &Gpsr::GetPredictedEntryLifetime),
+                   MakeTimeChecker())
+      .AddAttribute("PiggybackPosition",
+                   "Data frames carry the sender's position, and HELLOs are skipped while they do",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&Gpsr::m_piggybackPosition),
+                   MakeBooleanChecker())
+      .AddAttribute("ForwardingMetric", "Metric greedy forwarding ranks neighbors by",
+                   EnumValue(GpsrPtable::METRIC_DISTANCE),
+                   MakeEnumAccessor<GpsrPtable::Metric>(&Gpsr::SetForwardingMetric,
+                                                        &Gpsr::GetForwardingMetric),
+                   MakeEnumChecker(GpsrPtable::METRIC_DISTANCE, "Distance",
+                                   GpsrPtable::METRIC_PRR_DISTANCE, "PrrDistance",
+                                   GpsrPtable::METRIC_ETX_PROGRESS, "EtxProgress"))
+      .AddAttribute("HelloLoad", "HELLOs carry the occupancy of the MAC transmit queue",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&Gpsr::m_helloLoad),
+                   MakeBooleanChecker())
+      .AddAttribute("LoadTolerance",
+                   "Fraction of the best greedy score within which neighbors share traffic by load, 0 disables it",
+                   DoubleValue(0.0),
+                   MakeDoubleAccessor(&Gpsr::SetLoadTolerance,
+                                      &Gpsr::GetLoadTolerance),
+                   MakeDoubleChecker<double>(0.0, 1.0))
+      .AddAttribute("PerimeterLoopDetection",
+                   "Drop a perimeter packet about to traverse the first edge of its face again, "
+                   "only sound with a planar subgraph",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&Gpsr::m_perimeterLoopDetection),
+                   MakeBooleanChecker())
+      .AddAttribute("MaxPerimeterHops", "Perimeter hops a packet may take per recovery, 0 for no limit",
+                   UintegerValue(0),
+                   MakeUintegerAccessor(&Gpsr::m_maxPerimeterHops),
+                   MakeUintegerChecker<uint32_t>(0, 65535))
+      .AddAttribute("StaticHoldDown", "Time a static neighbor evicted by a link failure stays out of the table",
+                   TimeValue(Seconds(1)),
+                   MakeTimeAccessor(&Gpsr::m_staticHoldDown),
+                   MakeTimeChecker())
+      .AddAttribute("LinkFailureFeedback",
+                   "A frame that used up its MAC retries evicts its next hop and is routed again",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&Gpsr::m_linkFeedback),
+                   MakeBooleanChecker())
+      .AddTraceSource("Drop", "A data packet was dropped by GPSR",
+                      MakeTraceSourceAccessor(&Gpsr::m_dropTrace),
+                      "ns3::Gpsr::DropTracedCallback")
+      .AddTraceSource("Deliver", "A data packet was delivered, with the hops it took in each mode",
+                      MakeTraceSourceAccessor(&Gpsr::m_deliverTrace),
+                      "ns3::Gpsr::DeliverTracedCallback");
     return tid;
   }
 
 Gpsr::Gpsr() :
   m_helloInterval(Seconds(1)),
+  m_helloMode(HELLO_FIXED),
+  m_helloDistance(10.0),
+  m_minHelloInterval(Seconds(0.25)),
+  m_maxHelloInterval(Seconds(2.5)),
+  m_beaconSlot(Seconds(0)),
+  m_helloMotion(false),
+  m_piggybackPosition(false),
+  m_linkFeedback(false),
+  m_helloLoad(false),
+  m_perimeterLoopDetection(false),
+  m_maxPerimeterHops(0),
   m_maxQueueLen(64),
   m_maxQueueTime(Seconds(30)),
+  m_egressInterface(-1),
+  m_load(0.0),
+  m_positionValid(false),
   m_queue(m_maxQueueLen, m_maxQueueTime),
   m_perimeterMode(true),
-  m_uniformRandomVariable(CreateObject<UniformRandomVariable>())
+  m_dataHeaderMode(DATA_HEADER_FULL),
+  m_uniformRandomVariable(CreateObject<UniformRandomVariable>()),
+  m_staticHoldDown(Seconds(1)),
+  m_helloChurn(false),
+  m_advertised(false),
+  m_beaconId(0),
+  m_dataTx(0),
+  m_dataHeaderBytes(0),
+  m_forwarded(0),
+  m_forwardingCpu(0),
+  m_packetCopies(0),
+  m_delivered(0),
+  m_routeCacheBucket(0.0),
+  m_routeCacheEpoch(0),
+  m_routeCacheHits(0),
+  m_routeCacheMisses(0),
+  m_helloTx(0),
+  m_helloBytes(0),
+  m_helloSuppressed(0),
+  m_piggybackTx(0),
+  m_piggybackRx(0),
+  m_macRetries(0),
+  m_linkFailures(0),
+  m_rerouted(0),
+  m_reroutedDrops(0),
+  m_greedyHops(0),
+  m_perimeterHops(0),
+  m_modeSwitches(0),
+  m_perimeterLoopDrops(0),
+  m_perimeterBudgetDrops(0),
+  m_deliveredGreedyHops(0),
+  m_deliveredPerimeterHops(0),
+  m_deliveredModeSwitches(0)
 {
     // Initialize but don't schedule yet
     m_helloTimer.SetFunction(&Gpsr::SendHello, this);
@@ -100,6 +401,32 @@ Gpsr::~Gpsr()
 void
 Gpsr::DoDispose()
 {
+  NS_LOG_INFO("Queue: " << m_queue.GetDeliveredCount() << " delivered, "
+              << m_queue.GetExpiredCount() << " expired, "
+              << m_queue.GetDroppedCount() << " dropped");
+  NS_LOG_INFO("Data: " << m_dataTx << " sent, " << m_dataHeaderBytes << " GPSR header bytes, "
+              << m_forwarded << " forwarded in " << m_forwardingCpu << " ns, "
+              << m_packetCopies << " packet copies, " << m_delivered << " delivered");
+  NS_LOG_INFO("Route cache: " << m_routeCacheHits << " hits, " << m_routeCacheMisses << " misses");
+  NS_LOG_INFO("Hello: " << m_helloTx << " sent, " << m_helloBytes << " bytes, "
+              << m_helloSuppressed << " suppressed by " << m_piggybackTx << " piggybacked positions");
+  NS_LOG_INFO("MAC: " << m_macRetries << " failed attempts, " << m_linkFailures << " link failures, "
+              << m_rerouted << " rerouted, " << m_reroutedDrops << " of them dropped");
+  NS_LOG_INFO("Hops: " << m_greedyHops << " greedy, " << m_perimeterHops << " perimeter, "
+              << m_modeSwitches << " mode switches, " << m_perimeterLoopDrops << " loop drops, "
+              << m_perimeterBudgetDrops << " budget drops");
+  NS_LOG_INFO("Delivered packets: " << m_deliveredGreedyHops << " greedy hops, " << m_deliveredPerimeterHops
+              << " perimeter hops, " << m_deliveredModeSwitches << " mode switches");
+  CancelHello();
+  if (m_egressDevice) {
+    SetMacFeedback(m_egressDevice, false);
+  }
+  if (m_piggybackPosition && m_ipv4 && m_ipv4->GetObject<Node>()) {
+    m_ipv4->GetObject<Node>()->UnregisterProtocolHandler(MakeCallback(&Gpsr::OverhearData, this));
+  }
+  m_routeCache.clear();
+  SetMobilityModel(nullptr);
+  m_egressDevice = nullptr;
   m_ipv4 = 0;
   Ipv4RoutingProtocol::DoDispose();
 }
@@ -107,20 +434,26 @@ Gpsr::DoDispose()
 void
 Gpsr::DoInitialize()
 {
-    m_helloTimer.Cancel();
+    CancelHello();
     m_queueTimer.Cancel();
 
+    // The queue is built in the constructor, before attributes are applied
+    m_queue.SetMaxQueueLen(m_maxQueueLen);
+    m_queue.SetQueueTimeout(m_maxQueueTime);
+
     // Get the node pointer if not already available
     Ptr<Node> node = this->GetObject<Node>();
     if (node)
     {
         // Initialize random variable stream specific to this node/protocol instance
         m_uniformRandomVariable->SetStream(node->GetId() + this->GetProtocolNumber());
+        m_neighbors.SetSpreadStream(node->GetId() + this->GetProtocolNumber() + GPSR_SPREAD_STREAM_OFFSET);
     }
     else
     {
         // Fallback if node context is not available yet (should ideally not happen here)
         m_uniformRandomVariable->SetStream(Simulator::GetContext());
+        m_neighbors.SetSpreadStream(Simulator::GetContext() + GPSR_SPREAD_STREAM_OFFSET);
     }
 
 
@@ -128,7 +461,9 @@ Gpsr::DoInitialize()
     Time helloJitter = MicroSeconds(m_uniformRandomVariable->GetInteger(0, 10000)); // 0-10 ms jitter
     Time queueJitter = MicroSeconds(m_uniformRandomVariable->GetInteger(0, 10000)); // 0-10 ms jitter
 
-    m_helloTimer.Schedule(MilliSeconds(100) + helloJitter);
+    if (m_helloMode != HELLO_OFF) {
+      ScheduleHelloIn(MilliSeconds(100) + helloJitter);
+    }
     m_queueTimer.Schedule(MilliSeconds(500) + queueJitter);
     NS_LOG_INFO("Scheduled initial Hello Timer with " << helloJitter.GetMicroSeconds() << "us jitter.");
     NS_LOG_INFO("Scheduled initial Queue Timer with " << queueJitter.GetMicroSeconds() << "us jitter.");
@@ -136,11 +471,289 @@ Gpsr::DoInitialize()
     Ipv4RoutingProtocol::DoInitialize();
 }
 
+void
+Gpsr::SetNeighborTableBackend(GpsrPtable::Backend backend)
+{
+  m_neighbors.SetBackend(backend);
+}
+
+GpsrPtable::Backend
+Gpsr::GetNeighborTableBackend() const
+{
+  return m_neighbors.GetBackend();
+}
+
+void
+Gpsr::SetPlanarization(GpsrPtable::Planarization planarization)
+{
+  m_neighbors.SetPlanarization(planarization);
+}
+
+GpsrPtable::Planarization
+Gpsr::GetPlanarization() const
+{
+  return m_neighbors.GetPlanarization();
+}
+
+void
+Gpsr::SetPositionPrediction(bool prediction)
+{
+  m_neighbors.SetPrediction(prediction);
+}
+
+bool
+Gpsr::GetPositionPrediction() const
+{
+  return m_neighbors.GetPrediction();
+}
+
+void
+Gpsr::SetRadioRange(double range)
+{
+  m_neighbors.SetRadioRange(range);
+}
+
+double
+Gpsr::GetRadioRange() const
+{
+  return m_neighbors.GetRadioRange();
+}
+
+void
+Gpsr::SetPredictedEntryLifetime(Time lifetime)
+{
+  m_neighbors.SetPredictedLifetime(lifetime);
+}
+
+Time
+Gpsr::GetPredictedEntryLifetime() const
+{
+  return m_neighbors.GetPredictedLifetime();
+}
+
+void
+Gpsr::SetForwardingMetric(GpsrPtable::Metric metric)
+{
+  m_neighbors.SetMetric(metric);
+}
+
+GpsrPtable::Metric
+Gpsr::GetForwardingMetric() const
+{
+  return m_neighbors.GetMetric();
+}
+
+void
+Gpsr::SetLoadTolerance(double tolerance)
+{
+  m_neighbors.SetLoadTolerance(tolerance);
+}
+
+double
+Gpsr::GetLoadTolerance() const
+{
+  return m_neighbors.GetLoadTolerance();
+}
+
+double
+Gpsr::GetLoad() const
+{
+  return m_load;
+}
+
+void
+Gpsr::SampleLoad()
+{
+  if (!m_macQueue) {
+    return;
+  }
+  double capacity = m_macQueue->GetMaxSize().GetValue();
+  double occupancy = capacity > 0 ? std::min(1.0, m_macQueue->GetNPackets() / capacity) : 0.0;
+  m_load = (1 - GPSR_LOAD_ALPHA) * m_load + GPSR_LOAD_ALPHA * occupancy;
+}
+
+uint32_t
+Gpsr::GetDataTxCount() const
+{
+  return m_dataTx;
+}
+
+uint64_t
+Gpsr::GetDataHeaderBytes() const
+{
+  return m_dataHeaderBytes;
+}
+
+uint32_t
+Gpsr::GetForwardedCount() const
+{
+  return m_forwarded;
+}
+
+int64_t
+Gpsr::GetForwardingCpuNanoSeconds() const
+{
+  return m_forwardingCpu;
+}
+
+uint32_t
+Gpsr::GetPacketCopyCount() const
+{
+  return m_packetCopies;
+}
+
+uint32_t
+Gpsr::GetDeliveredCount() const
+{
+  return m_delivered;
+}
+
+uint32_t
+Gpsr::GetRouteCacheHits() const
+{
+  return m_routeCacheHits;
+}
+
+uint32_t
+Gpsr::GetRouteCacheMisses() const
+{
+  return m_routeCacheMisses;
+}
+
+uint32_t
+Gpsr::GetHelloTxCount() const
+{
+  return m_helloTx;
+}
+
+uint64_t
+Gpsr::GetHelloBytes() const
+{
+  return m_helloBytes;
+}
+
+uint32_t
+Gpsr::GetHelloSuppressedCount() const
+{
+  return m_helloSuppressed;
+}
+
+uint32_t
+Gpsr::GetPiggybackTxCount() const
+{
+  return m_piggybackTx;
+}
+
+uint32_t
+Gpsr::GetPiggybackRxCount() const
+{
+  return m_piggybackRx;
+}
+
+uint32_t
+Gpsr::GetMacRetryCount() const
+{
+  return m_macRetries;
+}
+
+uint32_t
+Gpsr::GetLinkFailureCount() const
+{
+  return m_linkFailures;
+}
+
+uint32_t
+Gpsr::GetReroutedCount() const
+{
+  return m_rerouted;
+}
+
+uint32_t
+Gpsr::GetReroutedDropCount() const
+{
+  return m_reroutedDrops;
+}
+
+uint32_t
+Gpsr::GetGreedyHopCount() const
+{
+  return m_greedyHops;
+}
+
+uint32_t
+Gpsr::GetPerimeterHopCount() const
+{
+  return m_perimeterHops;
+}
+
+uint32_t
+Gpsr::GetModeSwitchCount() const
+{
+  return m_modeSwitches;
+}
+
+uint64_t
+Gpsr::GetDeliveredGreedyHops() const
+{
+  return m_deliveredGreedyHops;
+}
+
+uint64_t
+Gpsr::GetDeliveredPerimeterHops() const
+{
+  return m_deliveredPerimeterHops;
+}
+
+uint64_t
+Gpsr::GetDeliveredModeSwitches() const
+{
+  return m_deliveredModeSwitches;
+}
+
+void
+Gpsr::AddStaticNeighbor(Ipv4Address neighbor, Vector position)
+{
+  m_staticNeighbors[neighbor] = position;
+  m_neighbors.AddStaticEntry(neighbor, position);
+}
+
+uint32_t
+Gpsr::GetPerimeterLoopDropCount() const
+{
+  return m_perimeterLoopDrops;
+}
+
+uint32_t
+Gpsr::GetPerimeterBudgetDropCount() const
+{
+  return m_perimeterBudgetDrops;
+}
+
 void
 Gpsr::Start()
 {
   m_queuedAddresses.clear();
   m_neighbors.Clear();
+  for (std::map<Ipv4Address, Vector>::const_iterator i = m_staticNeighbors.begin();
+       i != m_staticNeighbors.end(); ++i) {
+    m_neighbors.AddStaticEntry(i->first, i->second);
+  }
+
+  // UDP is aggregated after the routing protocol, so it can only be
+  // hooked once the simulation starts. Data packets then pass through
+  // AddHeaders on their way down to IP.
+  Ptr<UdpL4Protocol> udp = m_ipv4->GetObject<UdpL4Protocol>();
+  if (udp && m_downTarget.IsNull()) {
+    m_downTarget = udp->GetDownTarget();
+    udp->SetDownTarget(MakeCallback(&Gpsr::AddHeaders, this));
+  }
+
+  // Unicast data frames are only handed up at their next hop, the other
+  // neighbors are reached through a promiscuous handler
+  if (m_piggybackPosition) {
+    m_ipv4->GetObject<Node>()->RegisterProtocolHandler(MakeCallback(&Gpsr::OverhearData, this),
+                                                       Ipv4L3Protocol::PROT_NUMBER, nullptr, true);
+  }
 }
 
   bool
@@ -174,20 +787,47 @@ Gpsr::Start()
   GpsrDeferredRouteTag tag;
   if (p->PeekPacketTag(tag) && IsMyOwnAddress(origin)) {
     Ptr<Packet> packet = p->Copy();
+    ++m_packetCopies;
     packet->RemovePacketTag(tag);
     DeferredRouteOutput(packet, header, ucb, ecb);
     return true;
   }
 
-  // If this packet is for us, deliver it
+  // The sender header only describes the last hop, OverhearData has
+  // already taken the position from it
+  Ptr<const Packet> packet = p;
+  Ipv4Header ipHeader = header;
+  GpsrSenderTag senderTag;
+  if (p->PeekPacketTag(senderTag)) {
+    packet = StripSenderHeader(p, ipHeader);
+  }
+
+  // If this packet is for us, deliver it without its position header
   if (m_ipv4->IsDestinationAddress(dst, iif)) {
     NS_LOG_LOGIC("Local delivery to " << dst);
-    lcb(p, header, iif);
+    ++m_delivered;
+    GpsrHopsTag hopsTag;
+    packet->PeekPacketTag(hopsTag);
+    m_deliveredGreedyHops += hopsTag.m_greedy;
+    m_deliveredPerimeterHops += hopsTag.m_perimeter;
+    m_deliveredModeSwitches += hopsTag.m_switches;
+
+    GpsrPositionTag positionTag;
+    if (packet->PeekPacketTag(positionTag)) {
+      packet = StripPositionHeader(packet, ipHeader);
+    }
+    m_deliverTrace(packet, ipHeader, hopsTag.m_greedy, hopsTag.m_perimeter, hopsTag.m_switches);
+    lcb(packet, ipHeader, iif);
     return true;
   }
 
   // Forward packet using greedy algorithm
-  return ForwardingGreedy(p, header, ucb, ecb);
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  bool forwarded = ForwardingGreedy(packet, ipHeader, ucb, ecb);
+  m_forwardingCpu += std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - begin).count();
+  ++m_forwarded;
+  return forwarded;
 }
 
   Ptr<Ipv4Route>
@@ -207,7 +847,6 @@ Gpsr::Start()
     }
 
     sockerr = Socket::ERROR_NOTERROR;
-    Ptr<Ipv4Route> route = Create<Ipv4Route>();
     Ipv4Address dst = header.GetDestination();
 
     // Ignore broadcast packets for routing table lookup/forwarding
@@ -221,41 +860,10 @@ Gpsr::Start()
 
     // --- Start Destination Position Lookup ---
     Vector dstPos;
-    bool dstPosFound = false;
-    Ptr<MobilityModel> dstMobility = nullptr;
-
-    // Iterate through all nodes in the simulation to find the destination node
-    for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i)
-    {
-        Ptr<Node> node = NodeList::GetNode(i);
-        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-        if (ipv4)
-        {
-            // Check all interfaces of the node
-            for (uint32_t j = 0; j < ipv4->GetNInterfaces(); ++j)
-            {
-                // Check all addresses on the interface
-                for (uint32_t k = 0; k < ipv4->GetNAddresses(j); ++k)
-                {
-                    Ipv4InterfaceAddress ifaceAddr = ipv4->GetAddress(j, k);
-                    if (ifaceAddr.GetLocal() == dst)
-                    {
-                        dstMobility = node->GetObject<MobilityModel>();
-                        if (dstMobility)
-                        {
-                            dstPos = dstMobility->GetPosition();
-                            dstPosFound = true;
-                            NS_LOG_LOGIC("Found destination node " << node->GetId() << " at position " << dstPos << " for IP " << dst);
-                        } else {
-                            NS_LOG_WARN("Destination node " << node->GetId() << " found for IP " << dst << " but it has no mobility model.");
-                        }
-                        goto end_node_search_routeoutput; // Exit loops once found
-                    }
-                }
-            }
-        }
+    bool dstPosFound = GpsrLocationService::GetPosition(dst, dstPos);
+    if (dstPosFound) {
+        NS_LOG_LOGIC("Found destination position " << dstPos << " for IP " << dst);
     }
-    end_node_search_routeoutput:; // Label for goto
 
     if (!dstPosFound)
     {
@@ -274,50 +882,31 @@ Gpsr::Start()
 
     // Get my position
     Vector myPos;
-    Ptr<MobilityModel> MM = m_ipv4->GetObject<MobilityModel>();
-    if (MM) {
-      myPos.x = MM->GetPosition().x;
-      myPos.y = MM->GetPosition().y;
-    } else {
-      // Handle missing mobility model if needed, maybe return LoopbackRoute?
+    if (!GetMyPosition(myPos)) {
       NS_LOG_WARN("RouteOutput: Node has no mobility model.");
-      myPos = Vector(0,0,0); // Fallback position? Or error out?
       sockerr = Socket::ERROR_NOROUTETOHOST; 
       return LoopbackRoute(header, oif);
     }
 
+    // Neighbors are reached through the GPSR interface
+    if (!m_egressDevice) {
+      NS_LOG_WARN("No GPSR interface is up. Cannot create route to " << dst << ".");
+      sockerr = Socket::ERROR_NOROUTETOHOST;
+      return LoopbackRoute(header, oif); // Cannot route without interface
+    }
+
     // Check if destination is a neighbor
-    Ipv4Address nextHop;
+    Ptr<Ipv4Route> route;
     if (m_neighbors.IsNeighbor(dst)) {
-      nextHop = dst;
+      route = MakeRoute(dst, dst);
     } else {
-      nextHop = m_neighbors.BestNeighbor(dstPos, myPos);
+      route = GreedyRoute(dst, dstPos, myPos);
     }
 
-    if (nextHop != Ipv4Address::GetZero()) {
-      // Find the correct output device for the next hop
-      int32_t interfaceIndex = m_ipv4->GetInterfaceForAddress(nextHop);
-      Ptr<NetDevice> outputDevice = nullptr;
-      if (interfaceIndex < 0) {
-          NS_LOG_WARN("Could not find interface for next hop address " << nextHop << ". Cannot create route.");
-          sockerr = Socket::ERROR_NOROUTETOHOST;
-          return LoopbackRoute(header, oif); // Cannot route without interface
-      } else {
-          outputDevice = m_ipv4->GetNetDevice(static_cast<uint32_t>(interfaceIndex));
-          if (!outputDevice) {
-               NS_LOG_ERROR("Could not get NetDevice for interface index " << interfaceIndex << ". Cannot create route.");
-               sockerr = Socket::ERROR_NOROUTETOHOST;
-               return LoopbackRoute(header, oif);
-          }
-      }
-
-      // Fixed: Create route object for ucb
-      route->SetDestination(dst);
-      route->SetSource(header.GetSource()); // Source needed for the route object
-      route->SetGateway(nextHop);
-      route->SetOutputDevice(outputDevice); 
-
-      NS_LOG_DEBUG("Found route to " << dst << " via " << nextHop << " on interface " << interfaceIndex);
+    if (route) {
+      NS_LOG_DEBUG("Found route to " << dst << " via " << route->GetGateway() << " on interface " << m_egressInterface);
+      ++m_greedyHops;
+      CountHop(p, false);
       return route;
     } else {
       // No route found, defer for now
@@ -355,19 +944,13 @@ Gpsr::NotifyInterfaceUp(uint32_t interface)
   // Add the socket to the list of sockets for this interface
   m_socketAddresses.insert(std::make_pair(socket, iface));
 
-  // Check if the device supports MAC level TX error callback
-  // Removed: TxError handling is reverted for now
-  /*
-  Ptr<NetDevice> dev = l3->GetNetDevice(interface);
-  Ptr<WifiNetDevice> wifiDevice = DynamicCast<WifiNetDevice>(dev);
-  if (wifiDevice) {
-    Ptr<WifiMac> mac = wifiDevice->GetMac();
-    if (mac) {
-      // Fixed: Removed call to non-existent GetTxErrorCallback
-      // mac->TraceConnectWithoutContext("TxErrHeader", m_neighbors.GetTxErrorCallback());
-    }
+  // Neighbors are all on this interface, so every next hop leaves through
+  // its device. GPSR runs on one interface; the first one up wins.
+  if (!m_egressDevice) {
+    m_egressDevice = l3->GetNetDevice(interface);
+    m_egressInterface = interface;
+    SetMacFeedback(m_egressDevice, true);
   }
-  */
 }
 
 void
@@ -382,20 +965,215 @@ Gpsr::NotifyInterfaceDown(uint32_t interface)
     m_socketAddresses.erase(socket);
   }
 
-  // Remove trace callbacks if necessary
-  // Removed: TxError handling is reverted for now
-  /*
-  Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol>();
-  Ptr<NetDevice> dev = l3->GetNetDevice(interface);
-  Ptr<WifiNetDevice> wifiDevice = DynamicCast<WifiNetDevice>(dev);
-  if (wifiDevice) {
-    Ptr<WifiMac> mac = wifiDevice->GetMac();
-    if (mac) {
-      // Fixed: Removed call to non-existent GetTxErrorCallback
-      // mac->TraceDisconnectWithoutContext("TxErrHeader", m_neighbors.GetTxErrorCallback());
+  if (m_egressDevice && static_cast<int32_t>(interface) == m_egressInterface) {
+    SetMacFeedback(m_egressDevice, false);
+    m_egressDevice = nullptr;
+    m_egressInterface = -1;
+  }
+}
+
+void
+Gpsr::SetMacFeedback(Ptr<NetDevice> device, bool connect)
+{
+  Ptr<WifiNetDevice> wifiDevice = DynamicCast<WifiNetDevice>(device);
+  if (!wifiDevice || !wifiDevice->GetMac()) {
+    return;
+  }
+  Ptr<WifiMac> mac = wifiDevice->GetMac();
+  Ptr<WifiRemoteStationManager> manager = mac->GetWifiRemoteStationManager();
+
+  // Unicast data goes through the best effort queue
+  m_macQueue = connect ? mac->GetTxopQueue(mac->GetQosSupported() ? AC_BE : AC_BE_NQOS) : nullptr;
+
+  if (connect) {
+    manager->TraceConnectWithoutContext("MacTxDataFailed", MakeCallback(&Gpsr::NotifyTxFailed, this));
+    manager->TraceConnectWithoutContext("MacTxFinalDataFailed", MakeCallback(&Gpsr::NotifyTxFinalFailed, this));
+    mac->TraceConnectWithoutContext("DroppedMpdu", MakeCallback(&Gpsr::NotifyMacDrop, this));
+  } else {
+    manager->TraceDisconnectWithoutContext("MacTxDataFailed", MakeCallback(&Gpsr::NotifyTxFailed, this));
+    manager->TraceDisconnectWithoutContext("MacTxFinalDataFailed", MakeCallback(&Gpsr::NotifyTxFinalFailed, this));
+    mac->TraceDisconnectWithoutContext("DroppedMpdu", MakeCallback(&Gpsr::NotifyMacDrop, this));
+  }
+
+  // Link quality estimates need the SNR of every broadcast and the ACKs,
+  // which is not worth paying for under the distance metric
+  if (m_neighbors.GetMetric() == GpsrPtable::METRIC_DISTANCE) {
+    return;
+  }
+  Ptr<WifiPhy> phy = wifiDevice->GetPhy();
+  if (connect) {
+    mac->TraceConnectWithoutContext("AckedMpdu", MakeCallback(&Gpsr::NotifyAcked, this));
+    if (phy) {
+      phy->TraceConnectWithoutContext("MonitorSnifferRx", MakeCallback(&Gpsr::NotifyPhyRx, this));
+    }
+  } else {
+    mac->TraceDisconnectWithoutContext("AckedMpdu", MakeCallback(&Gpsr::NotifyAcked, this));
+    if (phy) {
+      phy->TraceDisconnectWithoutContext("MonitorSnifferRx", MakeCallback(&Gpsr::NotifyPhyRx, this));
+    }
+  }
+}
+
+Ipv4Address
+Gpsr::GetNeighborAddress(Mac48Address address)
+{
+  if (m_egressInterface < 0) {
+    return Ipv4Address::GetZero();
+  }
+
+  // Unicast next hops have been resolved, so the ARP cache knows them
+  Ptr<ArpCache> arp = m_ipv4->GetObject<Ipv4L3Protocol>()->GetInterface(m_egressInterface)->GetArpCache();
+  if (!arp) {
+    return Ipv4Address::GetZero();
+  }
+  std::list<ArpCache::Entry *> entries = arp->LookupInverse(address);
+  for (std::list<ArpCache::Entry *>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+    Ipv4Address neighbor = (*i)->GetIpv4Address();
+    if (m_neighbors.IsNeighbor(neighbor)) {
+      return neighbor;
+    }
+  }
+  return Ipv4Address::GetZero();
+}
+
+void
+Gpsr::NotifyTxFailed(Mac48Address address)
+{
+  ++m_macRetries;
+  if (m_neighbors.GetMetric() == GpsrPtable::METRIC_ETX_PROGRESS) {
+    Ipv4Address neighbor = GetNeighborAddress(address);
+    if (neighbor != Ipv4Address::GetZero()) {
+      m_neighbors.NotifyTxAttempt(neighbor, false);
+    }
+  }
+}
+
+void
+Gpsr::NotifyTxFinalFailed(Mac48Address address)
+{
+  ++m_linkFailures;
+  if (!m_linkFeedback) {
+    return;
+  }
+
+  // The station manager reports the failure before the MAC drops the frame,
+  // so the neighbor is gone by the time the packet is rerouted
+  Ipv4Address neighbor = GetNeighborAddress(address);
+  if (neighbor != Ipv4Address::GetZero()) {
+    NS_LOG_DEBUG("NotifyTxFinalFailed: No link to " << neighbor << " (" << address << "), evicting it");
+    m_neighbors.DeleteEntry(neighbor);
+
+    // Without HELLOs nothing else would bring a true link back
+    if (m_staticNeighbors.find(neighbor) != m_staticNeighbors.end()) {
+      Simulator::Schedule(m_staticHoldDown, &Gpsr::RestoreStaticNeighbor, this, neighbor);
     }
   }
-  */
+}
+
+void
+Gpsr::RestoreStaticNeighbor(Ipv4Address neighbor)
+{
+  std::map<Ipv4Address, Vector>::const_iterator i = m_staticNeighbors.find(neighbor);
+  if (!m_ipv4 || m_socketAddresses.empty() || i == m_staticNeighbors.end()) {
+    return;
+  }
+  NS_LOG_DEBUG("RestoreStaticNeighbor: " << neighbor << " is back after the hold-down");
+  m_neighbors.AddStaticEntry(neighbor, i->second);
+}
+
+void
+Gpsr::NotifyAcked(Ptr<const WifiMpdu> mpdu)
+{
+  Ipv4Address neighbor = GetNeighborAddress(mpdu->GetHeader().GetAddr1());
+  if (neighbor != Ipv4Address::GetZero()) {
+    m_neighbors.NotifyTxAttempt(neighbor, true);
+  }
+}
+
+void
+Gpsr::NotifyPhyRx(Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                  MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId)
+{
+  // Only broadcasts are sent by the IP source itself; those are our HELLOs
+  WifiMacHeader macHeader;
+  if (packet->PeekHeader(macHeader) == 0 || !macHeader.IsData() || !macHeader.GetAddr1().IsBroadcast()) {
+    return;
+  }
+
+  Ptr<Packet> copy = packet->Copy();
+  ++m_packetCopies;
+  copy->RemoveHeader(macHeader);
+  LlcSnapHeader llc;
+  copy->RemoveHeader(llc);
+  if (llc.GetType() != Ipv4L3Protocol::PROT_NUMBER) {
+    return;
+  }
+  Ipv4Header ipHeader;
+  copy->RemoveHeader(ipHeader);
+  if (!IsMyOwnAddress(ipHeader.GetSource())) {
+    m_neighbors.NotifySnr(ipHeader.GetSource(), signalNoise.signal - signalNoise.noise);
+  }
+}
+
+void
+Gpsr::NotifyMacDrop(WifiMacDropReason reason, Ptr<const WifiMpdu> mpdu)
+{
+  if (!m_linkFeedback || reason != WIFI_MAC_DROP_REACHED_RETRY_LIMIT || !mpdu->GetHeader().IsData()) {
+    return;
+  }
+
+  // The MSDU is the IP datagram behind its LLC/SNAP header
+  Ptr<Packet> packet = mpdu->GetPacket()->Copy();
+  ++m_packetCopies;
+  LlcSnapHeader llc;
+  packet->RemoveHeader(llc);
+  if (llc.GetType() != Ipv4L3Protocol::PROT_NUMBER) {
+    return;
+  }
+  Ipv4Header ipHeader;
+  packet->RemoveHeader(ipHeader);
+
+  // Not from within the MAC's own drop handling
+  Simulator::ScheduleNow(&Gpsr::Reroute, this, packet, ipHeader);
+}
+
+void
+Gpsr::Reroute(Ptr<Packet> packet, Ipv4Header header)
+{
+  NS_LOG_FUNCTION(this << packet->GetUid() << header.GetDestination());
+
+  // A reroute is another hop
+  if (header.GetTtl() <= 1) {
+    NS_LOG_DEBUG("Reroute: TTL expired for packet " << packet->GetUid());
+    m_dropTrace(packet, header, DROP_TTL);
+    return;
+  }
+  header.SetTtl(header.GetTtl() - 1);
+
+  Ptr<Packet> stripped = StripSenderHeader(packet, header);
+  ++m_rerouted;
+
+  UnicastForwardCallback ucb = MakeCallback(&Gpsr::SendRerouted, this);
+  ErrorCallback ecb = MakeCallback(&Gpsr::DropRerouted, this);
+  if (m_neighbors.GetSize() == 0) {
+    DeferredRouteOutput(stripped, header, ucb, ecb);
+  } else {
+    ForwardingGreedy(stripped, header, ucb, ecb);
+  }
+}
+
+void
+Gpsr::SendRerouted(Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  // The header is complete already, so skip forwarding and send it as is
+  m_ipv4->GetObject<Ipv4L3Protocol>()->SendWithHeader(p->Copy(), header, route);
+}
+
+void
+Gpsr::DropRerouted(Ptr<const Packet> p, const Ipv4Header &header, Socket::SocketErrno err)
+{
+  NS_LOG_DEBUG("Rerouted packet " << p->GetUid() << " to " << header.GetDestination() << " dropped, error " << err);
+  ++m_reroutedDrops;
 }
 
 void
@@ -403,6 +1181,11 @@ Gpsr::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION(this << " interface " << interface << " address " << address);
 
+  // Publish the address in the location service even if the interface is still down
+  if (address.GetLocal() != Ipv4Address::GetLoopback()) {
+    GpsrLocationService::AddAddress(address.GetLocal(), m_ipv4->GetObject<Node>());
+  }
+
   Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol>();
   if (!l3->IsUp(interface)) {
     return;
@@ -437,6 +1220,8 @@ Gpsr::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION(this);
 
+  GpsrLocationService::RemoveAddress(address.GetLocal());
+
   Ptr<Socket> socket = FindSocketWithInterfaceAddress(address);
   if (socket) {
     m_socketAddresses.erase(socket);
@@ -485,6 +1270,21 @@ void Gpsr::SetIpv4(Ptr<Ipv4> ipv4)
       NS_LOG_WARN("Device at index 0 is not LoopbackNetDevice?");
   }
 
+  // Mobility is normally installed before the internet stack; if not,
+  // GetMyPosition resolves it on first use
+  SetMobilityModel(m_ipv4->GetObject<MobilityModel>());
+
+  // Publish addresses that were assigned before GPSR was attached
+  Ptr<Node> node = m_ipv4->GetObject<Node>();
+  for (uint32_t i = 0; i < m_ipv4->GetNInterfaces(); ++i) {
+    for (uint32_t j = 0; j < m_ipv4->GetNAddresses(i); ++j) {
+      Ipv4Address addr = m_ipv4->GetAddress(i, j).GetLocal();
+      if (addr != Ipv4Address::GetLoopback()) {
+        GpsrLocationService::AddAddress(addr, node);
+      }
+    }
+  }
+
   Simulator::ScheduleNow(&Gpsr::Start, this);
 }
 
@@ -494,16 +1294,28 @@ void Gpsr::SetIpv4(Ptr<Ipv4> ipv4)
 
     // Get my position from mobility model
     Vector myPos;
-    Ptr<MobilityModel> MM = m_ipv4->GetObject<MobilityModel>();
-
-    if (MM) {
-      myPos.x = MM->GetPosition().x;
-      myPos.y = MM->GetPosition().y;
-    } else {
+    if (!GetMyPosition(myPos)) {
       NS_LOG_WARN("No mobility model available");
       return;
     }
 
+    // A data frame sent recently, and close enough to here, has already
+    // told the neighbors where we are
+    Time now = Simulator::Now();
+    if (m_piggybackPosition && m_advertised && !m_helloChurn &&
+        (m_helloMode == HELLO_FIXED
+         ? now - m_lastAdvertTime < m_helloInterval
+         : now - m_lastAdvertTime < m_maxHelloInterval &&
+           CalculateDistance(myPos, m_lastAdvertPos) < m_helloDistance)) {
+      NS_LOG_LOGIC("SendHello: Position advertised by data at " << m_lastAdvertTime.As(Time::S) << ", skipping HELLO");
+      ++m_helloSuppressed;
+      m_lastHelloPos = m_lastAdvertPos;
+      m_lastHelloVelocity = Vector();
+      m_lastHelloTime = m_lastAdvertTime;
+      ScheduleHello();
+      return;
+    }
+
     // Create hello packet with my position
     for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin();
           j != m_socketAddresses.end(); ++j) {
@@ -511,11 +1323,22 @@ void Gpsr::SetIpv4(Ptr<Ipv4> ipv4)
       Ipv4InterfaceAddress iface = j->second;
 
       GpsrHelloHeader helloHeader(myPos.x, myPos.y);
+      if (m_helloMotion) {
+        Vector velocity = m_mobility->GetVelocity();
+        helloHeader.SetMotion(velocity.x, velocity.y, Simulator::Now());
+      }
+      if (m_helloLoad) {
+        // Sampled here too, so the load of a node that stopped forwarding decays
+        SampleLoad();
+        helloHeader.SetLoad(m_load);
+      }
 
       Ptr<Packet> packet = Create<Packet>();
+      // Headers are prepended, so the type that RecvGpsr reads first goes
+      // on last and the Hello header ends the packet
       GpsrTypeHeader typeHeader(GPSR_HELLO);
-      packet->AddHeader(typeHeader);
       packet->AddHeader(helloHeader);
+      packet->AddHeader(typeHeader);
 
       // Send to broadcast address
       Ipv4Address destination;
@@ -526,18 +1349,102 @@ void Gpsr::SetIpv4(Ptr<Ipv4> ipv4)
       }
 
       // Removed excessive log message here
+      ++m_helloTx;
+      m_helloBytes += packet->GetSize() + GPSR_HELLO_OVERHEAD;
       socket->SendTo(packet, 0, InetSocketAddress(destination, GPSR_PORT));
           }
 
-    // Schedule next hello message with jitter
-    double min = -1 * GPSR_MAX_JITTER;
-    double max = GPSR_MAX_JITTER;
-    Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable>();
-    jitter->SetAttribute("Min", DoubleValue(min));
-    jitter->SetAttribute("Max", DoubleValue(max));
+    m_lastHelloPos = myPos;
+    m_lastHelloVelocity = m_helloMotion ? m_mobility->GetVelocity() : Vector();
+    m_lastHelloTime = now;
+    m_helloChurn = false;
+    ScheduleHello();
+  }
+
+void
+Gpsr::ScheduleHello()
+{
+  if (m_helloMode == HELLO_ADAPTIVE) {
+    ScheduleAdaptiveHello();
+    return;
+  }
+  if (m_helloMode == HELLO_OFF) {
+    return;
+  }
+
+  // Schedule next hello message with jitter, drawn from the node's stream
+  double min = -1 * GPSR_MAX_JITTER;
+  double max = GPSR_MAX_JITTER;
+  ScheduleHelloIn(m_helloInterval + Seconds(m_uniformRandomVariable->GetValue(min, max)));
+}
+
+void
+Gpsr::ScheduleAdaptiveHello()
+{
+  Time now = Simulator::Now();
+  Time earliest = std::max(now, m_lastHelloTime + m_minHelloInterval);
+  Time due = m_lastHelloTime + m_maxHelloInterval;
+
+  Vector myPos;
+  if (m_helloChurn) {
+    // A new neighbor has not heard our position yet
+    due = earliest;
+  } else if (GetMyPosition(myPos)) {
+    // Mobility models move in straight lines between course changes, so the
+    // time until the advertised position is HelloDistance off is exact
+    // until the next CourseChange, which reschedules. With motion in the
+    // HELLOs, neighbors extrapolate that position, so only the deviation
+    // from the advertised course counts.
+    double dt = (now - m_lastHelloTime).GetSeconds();
+    Vector advertised(m_lastHelloPos.x + m_lastHelloVelocity.x * dt,
+                      m_lastHelloPos.y + m_lastHelloVelocity.y * dt, 0);
+    double moved = CalculateDistance(myPos, advertised);
+    Vector velocity = m_mobility->GetVelocity() - m_lastHelloVelocity;
+    double speed = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+    if (moved >= m_helloDistance) {
+      due = earliest;
+    } else if (speed > 0) {
+      due = std::min(due, now + Seconds((m_helloDistance - moved) / speed));
+    }
+  }
+  due = std::max(due, earliest);
+
+  // Neighbors that see the same event would otherwise answer in lockstep
+  Time jitter = Seconds(m_uniformRandomVariable->GetValue(0, m_minHelloInterval.GetSeconds() / 2));
+
+  CancelHello();
+  ScheduleHelloIn(due - now + jitter);
+}
+
+void
+Gpsr::ScheduleHelloIn(Time delay)
+{
+  if (m_beaconSlot.IsStrictlyPositive()) {
+    m_beaconId = SimulationSingleton<GpsrBeaconScheduler>::Get()->Schedule(delay, m_beaconSlot,
+                                                                           MakeCallback(&Gpsr::SendHello, this));
+  } else {
+    m_helloTimer.Schedule(delay);
+  }
+}
+
+void
+Gpsr::CancelHello()
+{
+  m_helloTimer.Cancel();
+  if (m_beaconId != 0) {
+    SimulationSingleton<GpsrBeaconScheduler>::Get()->Cancel(m_beaconId);
+    m_beaconId = 0;
+  }
+}
 
-    m_helloTimer.Schedule(m_helloInterval + Seconds(jitter->GetValue(min, max)));
+bool
+Gpsr::IsHelloScheduled() const
+{
+  if (m_beaconId != 0) {
+    return SimulationSingleton<GpsrBeaconScheduler>::Get()->IsPending(m_beaconId);
   }
+  return m_helloTimer.IsRunning();
+}
 
   void
 Gpsr::RecvGpsr(Ptr<Socket> socket)
@@ -587,7 +1494,15 @@ Gpsr::RecvGpsr(Ptr<Socket> socket)
       NS_LOG_INFO("RecvGpsr: Processing HELLO from " << sender << " at position " << senderPos);
 
       // Update neighbor table
-      UpdateRouteToNeighbor(sender, senderPos);
+      if (helloHeader.HasMotion()) {
+        Vector senderVel(helloHeader.GetVelocityX(), helloHeader.GetVelocityY(), 0);
+        UpdateRouteToNeighbor(sender, senderPos, senderVel, helloHeader.GetTimestamp());
+      } else {
+        UpdateRouteToNeighbor(sender, senderPos);
+      }
+      if (helloHeader.HasLoad()) {
+        m_neighbors.SetNeighborLoad(sender, helloHeader.GetLoad());
+      }
 
     } else {
       // Added log for non-HELLO case
@@ -600,7 +1515,80 @@ Gpsr::UpdateRouteToNeighbor(Ipv4Address neighbor, Vector position)
 {
   NS_LOG_FUNCTION(this << neighbor << position);
   NS_LOG_INFO("UpdateRouteToNeighbor: Adding/Updating entry for " << neighbor << " at " << position);
+
+  // Only a new or moved neighbor can open a route that was not there before
+  m_neighbors.Purge();
+  bool added = !m_neighbors.IsNeighbor(neighbor);
+  bool changed = added || !(m_neighbors.GetPosition(neighbor) == position);
   m_neighbors.AddEntry(neighbor, position);
+  NeighborUpdated(neighbor, position, added, changed);
+}
+
+void
+Gpsr::UpdateRouteToNeighbor(Ipv4Address neighbor, Vector position, Vector velocity, Time timestamp)
+{
+  NS_LOG_FUNCTION(this << neighbor << position << velocity << timestamp);
+
+  // The table holds the position extrapolated to now, compare against that
+  m_neighbors.Purge();
+  bool added = !m_neighbors.IsNeighbor(neighbor);
+  Vector before = added ? GpsrPtable::GetInvalidPosition() : m_neighbors.GetPosition(neighbor);
+  m_neighbors.AddEntry(neighbor, position, velocity, timestamp);
+  Vector after = m_neighbors.GetPosition(neighbor);
+  NeighborUpdated(neighbor, after, added, added || !(before == after));
+}
+
+void
+Gpsr::NeighborUpdated(Ipv4Address neighbor, Vector position, bool added, bool changed)
+{
+  // Longest gap between two HELLOs of a neighbor that lost none
+  Time helloGap = m_helloMode == HELLO_ADAPTIVE ? m_maxHelloInterval + m_minHelloInterval / 2
+                                                : m_helloInterval + m_helloInterval / 2;
+  m_neighbors.NotifyReception(neighbor, helloGap);
+
+  // Lost neighbors need nothing from us, new ones need our position
+  if (added && m_helloMode == HELLO_ADAPTIVE && !m_helloChurn && IsHelloScheduled()) {
+    m_helloChurn = true;
+    ScheduleAdaptiveHello();
+  }
+
+  if (changed && !m_queuedAddresses.empty()) {
+    DrainQueueTowards(neighbor, position);
+  }
+}
+
+void
+Gpsr::DrainQueueTowards(Ipv4Address neighbor, Vector position)
+{
+  NS_LOG_FUNCTION(this << neighbor << position);
+
+  Vector myPos;
+  if (!GetMyPosition(myPos)) {
+    return;
+  }
+
+  // Destinations this neighbor makes progress towards
+  std::list<Ipv4Address> ready;
+  for (std::list<Ipv4Address>::const_iterator i = m_queuedAddresses.begin(); i != m_queuedAddresses.end(); ++i) {
+    Vector dstPos;
+    if (*i == neighbor ||
+        (GpsrLocationService::GetPosition(*i, dstPos) &&
+         CalculateDistance(position, dstPos) < CalculateDistance(myPos, dstPos))) {
+      ready.push_back(*i);
+    }
+  }
+
+  for (std::list<Ipv4Address>::iterator i = ready.begin(); i != ready.end(); ++i) {
+    NS_LOG_LOGIC("DrainQueueTowards: " << neighbor << " makes progress to " << *i << ", draining queue.");
+    if (SendPacketFromQueue(*i)) {
+      m_queuedAddresses.remove(*i);
+    }
+  }
+
+  // The timer is only a fallback for destinations no neighbor serves yet
+  if (m_queuedAddresses.empty()) {
+    m_queueTimer.Cancel();
+  }
 }
 
 bool
@@ -616,6 +1604,53 @@ Gpsr::IsMyOwnAddress(Ipv4Address addr)
   return false;
 }
 
+void
+Gpsr::SetMobilityModel(Ptr<MobilityModel> mobility)
+{
+  if (m_mobility) {
+    m_mobility->TraceDisconnectWithoutContext("CourseChange", MakeCallback(&Gpsr::NotifyCourseChange, this));
+  }
+  m_mobility = mobility;
+  m_positionValid = false;
+  if (m_mobility) {
+    m_mobility->TraceConnectWithoutContext("CourseChange", MakeCallback(&Gpsr::NotifyCourseChange, this));
+  }
+}
+
+void
+Gpsr::NotifyCourseChange(Ptr<const MobilityModel> mobility)
+{
+  m_positionValid = false;
+
+  // The new velocity moves the time the position goes stale
+  if (m_helloMode == HELLO_ADAPTIVE && IsHelloScheduled()) {
+    ScheduleAdaptiveHello();
+  }
+}
+
+bool
+Gpsr::GetMyPosition(Vector &position)
+{
+  if (!m_mobility) {
+    SetMobilityModel(m_ipv4->GetObject<MobilityModel>());
+    if (!m_mobility) {
+      return false;
+    }
+  }
+
+  // Everything handled in one event sees the same position, so evaluate
+  // the mobility model once per timestamp. Course changes within the
+  // timestamp invalidate the cached value.
+  Time now = Simulator::Now();
+  if (!m_positionValid || m_positionTime != now) {
+    m_position = m_mobility->GetPosition();
+    m_positionTime = now;
+    m_positionValid = true;
+  }
+  position = m_position;
+  return true;
+}
+
 void
 Gpsr::DeferredRouteOutput(Ptr<const Packet> p, const Ipv4Header &header,
                           UnicastForwardCallback ucb, ErrorCallback ecb)
@@ -670,128 +1705,68 @@ Gpsr::CheckQueue()
     NS_LOG_FUNCTION(this << dst);
     m_neighbors.Purge(); 
 
-    GpsrQueueEntry queueEntry;
-    if (!m_queue.Dequeue(dst, queueEntry)) {
-      NS_LOG_DEBUG("SendPacketFromQueue: No packet for " << dst << " found in queue.");
+    // Without any neighbor every packet would be dropped by the recovery
+    // mode; keep them queued until a neighbor shows up or they expire
+    if (m_neighbors.GetSize() == 0) {
+      NS_LOG_DEBUG("SendPacketFromQueue: No neighbors yet, keeping packets for " << dst << " queued.");
       return false;
     }
 
-    NS_LOG_DEBUG("SendPacketFromQueue: Dequeued packet UID " << queueEntry.GetPacket()->GetUid() << " for " << dst);
-
     // Get My Position
-    Ptr<MobilityModel> mm = m_ipv4->GetObject<MobilityModel>();
-    Vector myPos = mm ? mm->GetPosition() : Vector(0,0,0);
-    if (!mm) {
-      NS_LOG_WARN("SendPacketFromQueue: Node has no mobility model. Cannot route packet UID " << queueEntry.GetPacket()->GetUid() << ". Dropping.");
+    Vector myPos;
+    if (!GetMyPosition(myPos)) {
+      NS_LOG_WARN("SendPacketFromQueue: Node has no mobility model. Cannot route packets for " << dst << ". Dropping.");
       DropPacketWithDst(dst, "No mobility model");
-      return false;
+      return true;
     }
 
     // Get Destination Position (Oracle Lookup)
     Vector dstPos;
-    bool dstPosFound = false;
-    // Iterate through all nodes
-    for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i)
-    {
-        Ptr<Node> node = NodeList::GetNode(i);
-        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-        if (ipv4) {
-            for (uint32_t j = 0; j < ipv4->GetNInterfaces(); ++j) {
-                for (uint32_t k = 0; k < ipv4->GetNAddresses(j); ++k) {
-                    if (ipv4->GetAddress(j, k).GetLocal() == dst) {
-                        Ptr<MobilityModel> dstMobility = node->GetObject<MobilityModel>();
-                        if (dstMobility) {
-                            dstPos = dstMobility->GetPosition();
-                            dstPosFound = true;
-                            NS_LOG_LOGIC("SendPacketFromQueue: Found dstPos " << dstPos << " for " << dst);
-                        } else {
-                             NS_LOG_WARN("SendPacketFromQueue: Dest node " << node->GetId() << " for IP " << dst << " has no mobility model.");
-                        }
-                        goto end_node_search_sendfromqueue;
-                    }
-                }
-            }
-        }
+    bool dstPosFound = GpsrLocationService::GetPosition(dst, dstPos);
+    if (dstPosFound) {
+        NS_LOG_LOGIC("SendPacketFromQueue: Found dstPos " << dstPos << " for " << dst);
     }
-    end_node_search_sendfromqueue:;
 
     if (!dstPosFound) {
         NS_LOG_WARN("SendPacketFromQueue: Could not find position for destination IP " << dst << ". Dropping packets.");
         DropPacketWithDst(dst, "Destination position unknown"); // Drop all packets for this dest
-        return false;
+        return true;
     }
     // --- End Destination Position Lookup ---
 
-    // Find Best Neighbor (Greedy)
-    Ipv4Address nextHop = m_neighbors.BestNeighbor(dstPos, myPos);
+    // Send every packet queued for this destination in one pass
+    GpsrQueueEntry queueEntry;
+    while (m_queue.Dequeue(dst, queueEntry)) {
+      NS_LOG_DEBUG("SendPacketFromQueue: Dequeued packet UID " << queueEntry.GetPacket()->GetUid() << " for " << dst);
 
-    if (nextHop == Ipv4Address::GetZero()) {
-      // Greedy failed
-      NS_LOG_DEBUG("SendPacketFromQueue: No greedy next hop found for " << dst << ", checking perimeter mode.");
-      
-      if (m_perimeterMode)
-      {
-          NS_LOG_LOGIC("SendPacketFromQueue: Entering RecoveryMode for packet UID " << queueEntry.GetPacket()->GetUid());
-          // Packet from queue is assumed not to have a position header yet.
-          // Create a copy to add the header.
-          Ptr<Packet> packetCopy = ConstCast<Packet>(queueEntry.GetPacket())->Copy();
-          
-          GpsrPositionHeader recoveryHeader;
-          // Populate the header for recovery mode initiation
-          recoveryHeader.SetDstPositionX(dstPos.x);
-          recoveryHeader.SetDstPositionY(dstPos.y);
-          recoveryHeader.SetRecPositionX(myPos.x); // Position where recovery starts (here)
-          recoveryHeader.SetRecPositionY(myPos.y);
-          recoveryHeader.SetPrevPositionX(myPos.x); // First hop on perimeter is this node
-          recoveryHeader.SetPrevPositionY(myPos.y);
-          recoveryHeader.SetRecoveryFlag(true);
-          packetCopy->AddHeader(recoveryHeader);
-
-          // Call RecoveryMode with the packet COPY and info from queue entry
-          RecoveryMode(dst, packetCopy, queueEntry.GetUnicastForwardCallback(), queueEntry.GetIpv4Header(), queueEntry.GetErrorCallback());
-      } else {
-          // Recovery needed but disabled, drop the packet
-          NS_LOG_DEBUG("SendPacketFromQueue: Greedy failed, recovery disabled. Dropping packet UID " << queueEntry.GetPacket()->GetUid());
-          queueEntry.GetErrorCallback()(queueEntry.GetPacket(), queueEntry.GetIpv4Header(), Socket::ERROR_NOROUTETOHOST);
-          // We already dequeued it, so just return true (packet processed/dropped).
-      }
+      // Find Best Neighbor (Greedy)
+      Ptr<Ipv4Route> route = GreedyRoute(dst, dstPos, myPos);
 
-    } else {
-      // Greedy Succeeded
-      NS_LOG_DEBUG("SendPacketFromQueue: Found greedy next hop " << nextHop << " for " << dst);
-      // Send using the found greedy route
-      int32_t interfaceIndex = m_ipv4->GetInterfaceForAddress(nextHop);
-      Ptr<NetDevice> oif = nullptr;
-      if (interfaceIndex < 0) {
-          NS_LOG_WARN ("SendPacketFromQueue: Could not find Output Interface for next hop " << nextHop << ". Packet UID " << queueEntry.GetPacket()->GetUid() << " dropped.");
-          queueEntry.GetErrorCallback()(queueEntry.GetPacket(), queueEntry.GetIpv4Header(), Socket::ERROR_NOROUTETOHOST);
-          return false; // Return false as this specific packet failed
-      } else {
-          oif = m_ipv4->GetNetDevice(static_cast<uint32_t>(interfaceIndex));
-           if (!oif) {
-              NS_LOG_ERROR ("SendPacketFromQueue: Could not get Output NetDevice for interface index " << interfaceIndex << ". Packet UID " << queueEntry.GetPacket()->GetUid() << " dropped.");
-              queueEntry.GetErrorCallback()(queueEntry.GetPacket(), queueEntry.GetIpv4Header(), Socket::ERROR_NOROUTETOHOST);
-              return false; // Return false as this specific packet failed
-          }
-      }
+      if (!route) {
+        // Greedy failed
+        NS_LOG_DEBUG("SendPacketFromQueue: No greedy next hop found for " << dst << ", checking perimeter mode.");
 
-      // Create route and call UCB
-      Ptr<Ipv4Route> route = Create<Ipv4Route>();
-      route->SetDestination(dst);
-      route->SetSource(queueEntry.GetIpv4Header().GetSource());
-      route->SetGateway(nextHop);
-      route->SetOutputDevice(oif);
-      NS_LOG_LOGIC("SendPacketFromQueue: Calling UCB for Dst=" << dst << " NextHop=" << nextHop);
-      queueEntry.GetUnicastForwardCallback()(route, queueEntry.GetPacket(), queueEntry.GetIpv4Header());
-    }
+        if (m_perimeterMode)
+        {
+            NS_LOG_LOGIC("SendPacketFromQueue: Entering RecoveryMode for packet UID " << queueEntry.GetPacket()->GetUid());
+            EnterRecovery(dst, queueEntry.GetPacket(), dstPos, myPos, queueEntry.GetUnicastForwardCallback(),
+                          queueEntry.GetIpv4Header(), queueEntry.GetErrorCallback());
+        } else {
+            // Recovery needed but disabled, drop the packet
+            NS_LOG_DEBUG("SendPacketFromQueue: Greedy failed, recovery disabled. Dropping packet UID " << queueEntry.GetPacket()->GetUid());
+            queueEntry.GetErrorCallback()(queueEntry.GetPacket(), queueEntry.GetIpv4Header(), Socket::ERROR_NOROUTETOHOST);
+        }
+        continue;
+      }
 
-    // Check if there are more packets for this destination in the queue
-    if (m_queue.Find(dst)) {
-        NS_LOG_LOGIC("SendPacketFromQueue: More packets queued for " << dst << ". Scheduling CheckQueue.");
-        m_queueTimer.Schedule(Time(0)); // Check queue again immediately
+      // Greedy Succeeded
+      NS_LOG_LOGIC("SendPacketFromQueue: Calling UCB for Dst=" << dst << " NextHop=" << route->GetGateway());
+      ++m_greedyHops;
+      CountHop(queueEntry.GetPacket(), false);
+      SendData(queueEntry.GetUnicastForwardCallback(), route, queueEntry.GetPacket(), queueEntry.GetIpv4Header());
     }
 
-    return true; // Indicate packet was processed (sent, recovered, or dropped)
+    return true; // Every packet for dst was processed (sent, recovered, or dropped)
   }
 
 // Helper function to drop all packets for a destination and call error callback
@@ -799,12 +1774,9 @@ void
 Gpsr::DropPacketWithDst(Ipv4Address dst, std::string reason)
 {
     NS_LOG_FUNCTION(this << dst << reason);
-    GpsrQueueEntry queueEntry;
-    while (m_queue.Dequeue(dst, queueEntry))
-    {
-        NS_LOG_LOGIC("Dropping queued packet UID " << queueEntry.GetPacket()->GetUid() << " for " << dst << " Reason: " << reason);
-        queueEntry.GetErrorCallback()(queueEntry.GetPacket(), queueEntry.GetIpv4Header(), Socket::ERROR_NOROUTETOHOST);
-    }
+    NS_LOG_LOGIC("Dropping queued packets for " << dst << " Reason: " << reason);
+    // Counted as dropped, not delivered, and reported through each ecb
+    m_queue.DropPacketWithDst(dst);
 }
 
 bool
@@ -813,10 +1785,8 @@ Gpsr::ForwardingGreedy(Ptr<const Packet> p, const Ipv4Header &header,
 {
   NS_LOG_FUNCTION(this << p->GetUid() << header.GetDestination());
   Ipv4Address dst = header.GetDestination();
-  Ptr<MobilityModel> mm = m_ipv4->GetObject<MobilityModel>();
-  Vector myPos = mm ? mm->GetPosition() : Vector(0,0,0);
-
-  if (!mm) {
+  Vector myPos;
+  if (!GetMyPosition(myPos)) {
       NS_LOG_WARN("ForwardingGreedy: Node has no mobility model, cannot perform greedy routing.");
       ecb(p, header, Socket::ERROR_NOROUTETOHOST);
       return false;
@@ -825,208 +1795,210 @@ Gpsr::ForwardingGreedy(Ptr<const Packet> p, const Ipv4Header &header,
   // Get destination position from header OR use Oracle lookup
   Vector dstPos;
   GpsrPositionHeader gpsrHeader;
-  bool hasPositionHeader = p->PeekHeader(gpsrHeader);
+  bool hasPositionHeader = PeekPositionHeader(p, gpsrHeader);
 
   if (hasPositionHeader) {
       // If header exists, use position from it (might have been added by source or previous hop)
       dstPos = Vector(gpsrHeader.GetDstPositionX(), gpsrHeader.GetDstPositionY(), 0); 
-      // TODO: Ensure GetDstPositionX/Y exist.
       NS_LOG_LOGIC("ForwardingGreedy: Using dstPos from existing header: " << dstPos);
   } else {
       // If no header, perform Oracle lookup (consistent with RouteOutput)
       NS_LOG_LOGIC("ForwardingGreedy: No position header, performing Oracle lookup for " << dst);
-      bool dstPosFound = false;
-      Ptr<MobilityModel> dstMobility = nullptr;
-      // Simplified lookup - assumes destination node exists and has mobility
-      // A full lookup loop like in RouteOutput might be needed for robustness
-      for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i) {
-          Ptr<Node> node = NodeList::GetNode(i);
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-          if (ipv4) {
-              for (uint32_t j = 0; j < ipv4->GetNInterfaces(); ++j) {
-                  for (uint32_t k = 0; k < ipv4->GetNAddresses(j); ++k) {
-                      if (ipv4->GetAddress(j, k).GetLocal() == dst) {
-                          dstMobility = node->GetObject<MobilityModel>();
-                          if (dstMobility) {
-                              dstPos = dstMobility->GetPosition();
-                              dstPosFound = true;
-                              NS_LOG_LOGIC("Found destination node " << node->GetId() << " at position " << dstPos);
-                          } else {
-                               NS_LOG_WARN("Dest node " << node->GetId() << " for IP " << dst << " has no mobility model.");
-                          }
-                          goto end_node_search_forwarding; 
-                      }
-                  }
-              }
-          }
-      }
-      end_node_search_forwarding:;
-      if (!dstPosFound) {
+      if (!GpsrLocationService::GetPosition(dst, dstPos)) {
           NS_LOG_WARN("Could not find position for destination IP " << dst << ". Packet dropped.");
           ecb(p, header, Socket::ERROR_NOROUTETOHOST);
           return false;
       }
   }
 
-  // Find best neighbor using greedy approach
-  Ipv4Address nextHop = m_neighbors.BestNeighbor(dstPos, myPos);
-
-  if (nextHop != Ipv4Address::GetZero()) {
-    NS_LOG_DEBUG("ForwardingGreedy: Found next hop " << nextHop << " for dst " << dst);
-    int32_t interfaceIndex = m_ipv4->GetInterfaceForAddress(nextHop);
-    Ptr<NetDevice> oif = nullptr;
-    if (interfaceIndex < 0) {
-        NS_LOG_WARN ("ForwardingGreedy: Could not find Output Interface for next hop " << nextHop);
-        ecb(p, header, Socket::ERROR_NOROUTETOHOST);
-        return false;
-    } else {
-        oif = m_ipv4->GetNetDevice(static_cast<uint32_t>(interfaceIndex));
-         if (!oif) {
-            NS_LOG_ERROR ("ForwardingGreedy: Could not get Output NetDevice for interface index " << interfaceIndex);
-            ecb(p, header, Socket::ERROR_NOROUTETOHOST);
-            return false;
-        }
+  // A packet on the perimeter only returns to greedy once it is closer to
+  // the destination than where it entered the perimeter. Before that, a
+  // neighbor closer than this node can still lead back into the same void.
+  bool inRecovery = hasPositionHeader && gpsrHeader.GetRecoveryFlag();
+  if (inRecovery) {
+    Vector recPos(gpsrHeader.GetRecPositionX(), gpsrHeader.GetRecPositionY(), 0);
+    if (CalculateDistance(myPos, dstPos) >= CalculateDistance(recPos, dstPos)) {
+      NS_LOG_DEBUG("ForwardingGreedy: Not past recovery point " << recPos << " yet, staying on the perimeter.");
+      RecoveryMode(dst, p, gpsrHeader, ucb, header, ecb);
+      return true;
     }
+  }
 
-    // Fixed: Create Ipv4Route object and call ucb correctly
-    Ptr<Ipv4Route> route = Create<Ipv4Route>();
-    route->SetDestination(dst);
-    route->SetSource(header.GetSource());
-    route->SetGateway(nextHop);
-    route->SetOutputDevice(oif);
-    NS_LOG_LOGIC("ForwardingGreedy: Calling UCB for Dst=" << dst << " NextHop=" << nextHop);
-    ucb(route, p, header);
+  // Find best neighbor using greedy approach
+  Ptr<Ipv4Route> route = GreedyRoute(dst, dstPos, myPos);
+
+  if (route) {
+    NS_LOG_DEBUG("ForwardingGreedy: Found next hop " << route->GetGateway() << " for dst " << dst);
+
+    // Back in greedy mode the recovery state is dead weight
+    Ipv4Header greedyHeader = header;
+    Ptr<const Packet> packet = p;
+    if (inRecovery) {
+        NS_LOG_DEBUG("ForwardingGreedy: Past the recovery point, back to greedy for dst " << dst);
+        ++m_modeSwitches;
+        packet = LeaveRecovery(p, gpsrHeader, greedyHeader);
+    }
+    NS_LOG_LOGIC("ForwardingGreedy: Calling UCB for Dst=" << dst << " NextHop=" << route->GetGateway());
+    ++m_greedyHops;
+    CountHop(packet, false);
+    SendData(ucb, route, packet, greedyHeader);
     return true;
 
   } else if (m_perimeterMode) {
-    // Greedy failed, enter Recovery / Perimeter mode if not already in it
-    NS_LOG_DEBUG("ForwardingGreedy: No closer neighbor found for " << dst << ". Checking recovery status.");
-
-    GpsrPositionHeader existingHeader;
-    bool alreadyInRecovery = p->PeekHeader(existingHeader) && existingHeader.GetRecoveryFlag();
-
-    if (alreadyInRecovery) {
-        // Packet is already in recovery mode, just forward using RecoveryMode logic
-        NS_LOG_DEBUG("ForwardingGreedy: Packet already in recovery. Passing to RecoveryMode.");
-        // Need to pass the *original* packet (p), not a copy, as header should exist.
-        // RecoveryMode itself will make copies if needed for header updates.
-        RecoveryMode(dst, ConstCast<Packet>(p), ucb, header, ecb); 
-    } else {
-        // Packet is not in recovery, initiate recovery mode
-        NS_LOG_DEBUG("ForwardingGreedy: Initiating recovery mode.");
-        // Create a *mutable* copy of the packet to add the header
-        Ptr<Packet> packetCopy = p->Copy();
-
-        // Remove any potentially stale/incorrect position header before adding the new one.
-        // This is safer if the packet somehow had a non-recovery position header.
-        GpsrPositionHeader removedHeader; 
-        packetCopy->RemoveHeader(removedHeader); 
-
-        // Populate the header for recovery mode initiation
-        GpsrPositionHeader recoveryHeader;
-        recoveryHeader.SetDstPositionX(dstPos.x);
-        recoveryHeader.SetDstPositionY(dstPos.y);
-        recoveryHeader.SetRecPositionX(myPos.x); // Position where recovery starts
-        recoveryHeader.SetRecPositionY(myPos.y);
-        recoveryHeader.SetPrevPositionX(myPos.x); // First hop on perimeter is this node
-        recoveryHeader.SetPrevPositionY(myPos.y);
-        recoveryHeader.SetRecoveryFlag(true);
-        // TODO: Ensure GpsrPositionHeader has these fields and Setters.
-
-        packetCopy->AddHeader(recoveryHeader);
-
-        // Call RecoveryMode function (passing the *copy* with the header)
-        RecoveryMode(dst, packetCopy, ucb, header, ecb); // Note: ecb is now passed to RecoveryMode
-    }
+    // Greedy failed. A packet already in recovery is past its recovery
+    // point, so this is a new local minimum and a new perimeter starts here.
+    NS_LOG_DEBUG("ForwardingGreedy: No closer neighbor found for " << dst << ", initiating recovery mode.");
+    EnterRecovery(dst, p, dstPos, myPos, ucb, header, ecb);
     return true; // Packet is handled by RecoveryMode (either forwarded or dropped)
 
   } else {
     // Greedy failed and Perimeter mode is disabled
     NS_LOG_DEBUG("ForwardingGreedy: No closer neighbor and no recovery mode for dst " << dst << ". Packet dropped.");
-    ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+    DropData(p, header, DROP_NO_ROUTE, ecb);
     return false;
   }
 }
 
-void Gpsr::RecoveryMode(Ipv4Address dst, Ptr<Packet> p, UnicastForwardCallback ucb, Ipv4Header header, const ErrorCallback &ecb)
+void
+Gpsr::EnterRecovery(Ipv4Address dst, Ptr<const Packet> p, Vector dstPos, Vector myPos,
+                    UnicastForwardCallback ucb, const Ipv4Header &header, const ErrorCallback &ecb)
+{
+  GpsrPositionHeader recoveryHeader;
+  recoveryHeader.SetDstPositionX(dstPos.x);
+  recoveryHeader.SetDstPositionY(dstPos.y);
+  recoveryHeader.SetRecPositionX(myPos.x); // Position where recovery starts
+  recoveryHeader.SetRecPositionY(myPos.y);
+  recoveryHeader.SetPrevPositionX(myPos.x); // First hop on perimeter is this node
+  recoveryHeader.SetPrevPositionY(myPos.y);
+  recoveryHeader.SetFacePositionX(myPos.x); // First face is entered here too
+  recoveryHeader.SetFacePositionY(myPos.y);
+  recoveryHeader.SetRecoveryFlag(true);
+  ++m_modeSwitches;
+
+  // The header replaces any greedy one once the next hop is known
+  RecoveryMode(dst, p, recoveryHeader, ucb, header, ecb);
+}
+
+void Gpsr::RecoveryMode(Ipv4Address dst, Ptr<const Packet> p, GpsrPositionHeader gpsrHeader,
+                        UnicastForwardCallback ucb, Ipv4Header header, const ErrorCallback &ecb)
 {
     NS_LOG_FUNCTION(this << dst << p->GetUid());
 
     // Get my position
-    Ptr<MobilityModel> MM = m_ipv4->GetObject<MobilityModel>();
-    Vector myPos = MM ? MM->GetPosition() : Vector(0,0,0);
-    if (!MM) {
+    Vector myPos;
+    if (!GetMyPosition(myPos)) {
         NS_LOG_WARN("RecoveryMode: Node has no mobility model, cannot perform perimeter routing.");
         // Fixed: Use correct error code
         ecb(p, header, Socket::ERROR_NOROUTETOHOST);
         return;
     }
 
-    // Get Header info
-    GpsrPositionHeader gpsrHeader;
-    if (!p->PeekHeader(gpsrHeader)) {
-        NS_LOG_ERROR("RecoveryMode: Packet is missing GpsrPositionHeader!");
-        // Fixed: Use correct error code
-        ecb(p, header, Socket::ERROR_NOROUTETOHOST); 
-        return;
-    }
     // Extract positions from header
     Vector prevPos = Vector(gpsrHeader.GetPrevPositionX(), gpsrHeader.GetPrevPositionY(), 0);
     Vector dstPos = Vector(gpsrHeader.GetDstPositionX(), gpsrHeader.GetDstPositionY(), 0);
     // Fixed: Extract recPos needed for BestAngle
     Vector recPos = Vector(gpsrHeader.GetRecPositionX(), gpsrHeader.GetRecPositionY(), 0);
+    Vector facePos = Vector(gpsrHeader.GetFacePositionX(), gpsrHeader.GetFacePositionY(), 0);
 
-    NS_LOG_DEBUG("RecoveryMode: MyPos=" << myPos << " DstPos=" << dstPos << " PrevPos=" << prevPos << " RecPos=" << recPos);
+    NS_LOG_DEBUG("RecoveryMode: MyPos=" << myPos << " DstPos=" << dstPos << " PrevPos=" << prevPos
+                 << " RecPos=" << recPos << " FacePos=" << facePos);
 
     // Use the right-hand rule to find the next hop
     // Fixed: Pass recPos to BestAngle
     Ipv4Address nextHop = m_neighbors.BestAngle(dstPos, recPos, myPos, prevPos);
 
+    // Face change: an edge crossing the recPos-dstPos line closer to the
+    // destination than where the current face was entered leads onto the
+    // next face. Take that point as the new face entry and rotate
+    // counter-clockwise to the next edge. Each step moves the crossing
+    // strictly closer to dst, the neighbor count bounds it anyway. Faces
+    // only exist on a planar subgraph, so without one the plain right-hand
+    // rule is kept.
+    bool faceChanged = false;
+    uint32_t faceSteps = GetPlanarization() != GpsrPtable::PLANAR_NONE ? m_neighbors.GetSize() : 0;
+    for (uint32_t n = faceSteps; nextHop != Ipv4Address::GetZero() && n > 0; --n) {
+        Vector nextPos = m_neighbors.GetPosition(nextHop);
+        Vector cross;
+        if (!GpsrPtable::SegmentIntersection(myPos, nextPos, recPos, dstPos, cross) ||
+            CalculateDistance(cross, dstPos) >= CalculateDistance(facePos, dstPos)) {
+            break;
+        }
+        facePos = cross;
+        faceChanged = true;
+        NS_LOG_DEBUG("RecoveryMode: Edge to " << nextHop << " crosses the recovery line at " << cross << ", changing face.");
+
+        Ipv4Address rotated = m_neighbors.BestAngle(dstPos, recPos, myPos, nextPos);
+        if (rotated == Ipv4Address::GetZero()) {
+            break;
+        }
+        nextHop = rotated;
+    }
+
     if (nextHop != Ipv4Address::GetZero()) {
         NS_LOG_DEBUG("RecoveryMode: Found next hop " << nextHop << " using right-hand rule.");
 
-        // Create a copy of the packet to modify header for the next hop
-        Ptr<Packet> packetCopy = p->Copy();
-        GpsrPositionHeader oldHeader;
-        packetCopy->RemoveHeader(oldHeader); // Remove the old header
+        // Send the packet
+        if (!m_egressDevice) {
+            NS_LOG_WARN ("RecoveryMode: No GPSR interface is up for next hop " << nextHop);
+            ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+            return;
+        }
 
-        // Update the header: Previous hop position becomes current node's position
-        GpsrPositionHeader newHeader = oldHeader; 
-        newHeader.SetPrevPositionX(myPos.x);
-        newHeader.SetPrevPositionY(myPos.y);
-        packetCopy->AddHeader(newHeader); // Add the updated header
+        // The first edge taken on a face marks its start: coming back to it
+        // means the whole face was toured without finding an exit, and the
+        // destination is unreachable. The header keeps the plane only.
+        Vector here = Vector(myPos.x, myPos.y, 0);
+        Vector nextPos = m_neighbors.GetPosition(nextHop);
+        nextPos.z = 0;
+        Vector edgeFrom = gpsrHeader.GetFirstEdgeFrom();
+        Vector edgeTo = gpsrHeader.GetFirstEdgeTo();
+        if (faceChanged || CalculateDistance(edgeFrom, edgeTo) < GPSR_POSITION_EPSILON) {
+            gpsrHeader.SetFirstEdge(here, nextPos);
+        } else if (m_perimeterLoopDetection &&
+                   CalculateDistance(edgeFrom, here) < GPSR_POSITION_EPSILON &&
+                   CalculateDistance(edgeTo, nextPos) < GPSR_POSITION_EPSILON) {
+            NS_LOG_DEBUG("RecoveryMode: Back at the first edge of the face towards " << nextHop << ", dst " << dst << " is unreachable.");
+            ++m_perimeterLoopDrops;
+            DropData(p, header, DROP_PERIMETER_LOOP, ecb);
+            return;
+        }
 
-        // Send the packet
-        int32_t interfaceIndex = m_ipv4->GetInterfaceForAddress(nextHop);
-        Ptr<NetDevice> oif = nullptr;
-        if (interfaceIndex < 0) {
-            NS_LOG_WARN ("RecoveryMode: Could not find Output Interface for next hop " << nextHop);
-            ecb(packetCopy, header, Socket::ERROR_NOROUTETOHOST);
+        uint32_t perimeterHops = gpsrHeader.GetPerimeterHops() + 1;
+        if (m_maxPerimeterHops > 0 && perimeterHops > m_maxPerimeterHops) {
+            NS_LOG_DEBUG("RecoveryMode: Perimeter hop budget of " << m_maxPerimeterHops << " used up for dst " << dst << ".");
+            ++m_perimeterBudgetDrops;
+            DropData(p, header, DROP_PERIMETER_BUDGET, ecb);
             return;
-        } else {
-            oif = m_ipv4->GetNetDevice(static_cast<uint32_t>(interfaceIndex));
-            if (!oif) {
-                NS_LOG_ERROR ("RecoveryMode: Could not get Output NetDevice for interface index " << interfaceIndex);
-                ecb(packetCopy, header, Socket::ERROR_NOROUTETOHOST);
-                return;
-            }
         }
-        
-        // Fixed: Create Ipv4Route object and call ucb correctly
-        Ptr<Ipv4Route> route = Create<Ipv4Route>();
-        route->SetDestination(dst);
-        route->SetSource(header.GetSource()); // Use original header source
-        route->SetGateway(nextHop);
-        route->SetOutputDevice(oif);
+        gpsrHeader.SetPerimeterHops(static_cast<uint16_t>(std::min<uint32_t>(perimeterHops, 65535)));
+
+        // Previous hop position becomes current node's position. This is
+        // the only copy of the packet made on a perimeter hop, the old
+        // header is dropped by size without being parsed again.
+        gpsrHeader.SetPrevPositionX(myPos.x);
+        gpsrHeader.SetPrevPositionY(myPos.y);
+        gpsrHeader.SetFacePositionX(facePos.x);
+        gpsrHeader.SetFacePositionY(facePos.y);
+        Ptr<Packet> packetCopy = SetPositionHeader(p, gpsrHeader, header);
+
         NS_LOG_LOGIC("RecoveryMode: Calling UCB for Dst=" << dst << " NextHop=" << nextHop);
-        ucb(route, packetCopy, header);
+        ++m_perimeterHops;
+        CountHop(packetCopy, true);
+        SendData(ucb, MakeRoute(dst, nextHop), packetCopy, header);
 
     } else {
         NS_LOG_WARN("RecoveryMode: No next hop found using right-hand rule for dst " << dst << ". Packet dropped.");
-        ecb(p, header, Socket::ERROR_NOROUTETOHOST); // Notify caller
+        DropData(p, header, DROP_NO_ROUTE, ecb); // Notify caller
     }
 }
 
+void
+Gpsr::DropData(Ptr<const Packet> p, const Ipv4Header &header, DropReason reason, const ErrorCallback &ecb)
+{
+  m_dropTrace(p, header, reason);
+  ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+}
+
 Ptr<Ipv4Route>
 Gpsr::LoopbackRoute(const Ipv4Header &header, Ptr<NetDevice> oif)
 {
@@ -1097,6 +2069,23 @@ Gpsr::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
   // Print neighbors from position table
   // This is a placeholder - actual implementation would print neighbor info
 
+  *os << "Queue: " << m_queue.GetDeliveredCount() << " delivered, "
+      << m_queue.GetExpiredCount() << " expired, "
+      << m_queue.GetDroppedCount() << " dropped" << std::endl;
+  *os << "Data: " << m_dataTx << " sent, " << m_dataHeaderBytes << " GPSR header bytes, "
+      << m_forwarded << " forwarded, " << m_packetCopies << " packet copies" << std::endl;
+  *os << "Route cache: " << m_routeCacheHits << " hits, " << m_routeCacheMisses << " misses" << std::endl;
+  *os << "Hello: " << m_helloTx << " sent, " << m_helloBytes << " bytes, "
+      << m_helloSuppressed << " suppressed, " << m_piggybackTx << " piggybacked, "
+      << m_piggybackRx << " overheard" << std::endl;
+  *os << "MAC: " << m_macRetries << " failed attempts, " << m_linkFailures << " link failures, "
+      << m_rerouted << " rerouted, " << m_reroutedDrops << " of them dropped" << std::endl;
+  *os << "Hops: " << m_greedyHops << " greedy, " << m_perimeterHops << " perimeter, "
+      << m_modeSwitches << " mode switches, " << m_perimeterLoopDrops << " loop drops, "
+      << m_perimeterBudgetDrops << " budget drops" << std::endl;
+  *os << "Delivered packets: " << m_deliveredGreedyHops << " greedy hops, " << m_deliveredPerimeterHops
+      << " perimeter hops, " << m_deliveredModeSwitches << " mode switches" << std::endl;
+  *os << "Load: " << m_load << ", load tolerance: " << m_neighbors.GetLoadTolerance() << std::endl;
   *os << std::endl;
 }
 
@@ -1124,57 +2113,248 @@ Gpsr::GetDownTarget(void) const
 {
     NS_LOG_FUNCTION(this << p << source << destination);
 
-    // Get destination position using Oracle lookup
+    // HELLOs and other broadcasts have no destination position
     Vector dstPos;
-    bool dstPosFound = false;
-    Ptr<MobilityModel> dstMobility = nullptr;
+    if (destination.IsBroadcast() || !GpsrLocationService::GetPosition(destination, dstPos)) {
+        m_downTarget(p, source, destination, protocol, route);
+        return;
+    }
+    NS_LOG_LOGIC("AddHeaders: Found destination position " << dstPos << " for IP " << destination);
+
+    // In DATA_HEADER_NONE greedy packets go out bare. Otherwise the packet
+    // is not in recovery yet, so only the destination goes on the wire in
+    // the compact format.
+    uint32_t headerSize = 0;
+    if (m_dataHeaderMode != DATA_HEADER_NONE) {
+        GpsrPositionHeader gpsrHeader;
+        gpsrHeader.SetDstPositionX(dstPos.x);
+        gpsrHeader.SetDstPositionY(dstPos.y);
+        gpsrHeader.SetRecoveryFlag(false);
+        p->AddHeader(gpsrHeader);
+        p->AddPacketTag(GpsrPositionTag());
+        headerSize = gpsrHeader.GetSerializedSize();
+    }
 
-    // Iterate through all nodes (same logic as RouteOutput/ForwardingGreedy)
-    for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i)
-    {
-        Ptr<Node> node = NodeList::GetNode(i);
-        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-        if (ipv4) {
-            for (uint32_t j = 0; j < ipv4->GetNInterfaces(); ++j) {
-                for (uint32_t k = 0; k < ipv4->GetNAddresses(j); ++k) {
-                    if (ipv4->GetAddress(j, k).GetLocal() == destination) {
-                        dstMobility = node->GetObject<MobilityModel>();
-                        if (dstMobility) {
-                            dstPos = dstMobility->GetPosition();
-                            dstPosFound = true;
-                            NS_LOG_LOGIC("AddHeaders: Found destination node " << node->GetId() << " at position " << dstPos << " for IP " << destination);
-                        } else {
-                             NS_LOG_WARN("AddHeaders: Dest node " << node->GetId() << " for IP " << destination << " has no mobility model.");
-                        }
-                        goto end_node_search_addheaders;
-                    }
-                }
-            }
+    // Deferred packets are counted, and get their sender header, when they
+    // leave the queue
+    if (route && route->GetOutputDevice() != m_lo) {
+        if (m_piggybackPosition) {
+            headerSize += PutSenderHeader(p, source);
         }
+        ++m_dataTx;
+        m_dataHeaderBytes += headerSize;
     }
-    end_node_search_addheaders:;
+    m_downTarget(p, source, destination, protocol, route);
+}
 
-    if (!dstPosFound) {
-        NS_LOG_ERROR("AddHeaders: Could not find position for destination IP " << destination << ". Header not added/incomplete.");
-        // Decide how to handle this - maybe don't add header? Or add with invalid pos?
-        // For now, let's proceed but log the error. The routing might fail later.
-        // Setting dstPos to (0,0,0) as a fallback.
-        dstPos = Vector(0,0,0);
+bool
+Gpsr::PeekPositionHeader(Ptr<const Packet> p, GpsrPositionHeader &gpsrHeader) const
+{
+  GpsrPositionTag positionTag;
+  return p->PeekPacketTag(positionTag) && p->PeekHeader(gpsrHeader) > 0;
+}
+
+Ptr<Packet>
+Gpsr::SetPositionHeader(Ptr<const Packet> p, const GpsrPositionHeader &gpsrHeader, Ipv4Header &header)
+{
+  Ptr<Packet> packet = p->Copy();
+  ++m_packetCopies;
+  GpsrPositionTag positionTag;
+  if (packet->PeekPacketTag(positionTag)) {
+    packet->RemoveAtStart(GpsrPositionHeader::PeekSerializedSize(packet));
+  } else {
+    packet->AddPacketTag(positionTag);
+  }
+  packet->AddHeader(gpsrHeader);
+
+  // The receiver trims the payload to this size
+  header.SetPayloadSize(packet->GetSize());
+  return packet;
+}
+
+Ptr<Packet>
+Gpsr::StripPositionHeader(Ptr<const Packet> p, Ipv4Header &header)
+{
+  Ptr<Packet> packet = p->Copy();
+  ++m_packetCopies;
+  GpsrPositionTag positionTag;
+  if (packet->RemovePacketTag(positionTag)) {
+    packet->RemoveAtStart(GpsrPositionHeader::PeekSerializedSize(packet));
+    header.SetPayloadSize(packet->GetSize());
+  }
+  return packet;
+}
+
+Ptr<const Packet>
+Gpsr::LeaveRecovery(Ptr<const Packet> p, GpsrPositionHeader gpsrHeader, Ipv4Header &header)
+{
+  switch (m_dataHeaderMode) {
+    case DATA_HEADER_NONE:
+      return StripPositionHeader(p, header);
+    case DATA_HEADER_STUB:
+      gpsrHeader.SetRecoveryFlag(false);
+      return SetPositionHeader(p, gpsrHeader, header);
+    default:
+      return p;
+  }
+}
+
+Ptr<Ipv4Route>
+Gpsr::MakeRoute(Ipv4Address dst, Ipv4Address nextHop) const
+{
+  // IP forwarding only looks at the gateway and the device; the source is
+  // what a locally originated packet is sent from
+  Ptr<Ipv4Route> route = Create<Ipv4Route>();
+  route->SetDestination(dst);
+  route->SetSource(m_ipv4->GetAddress(m_egressInterface, 0).GetLocal());
+  route->SetGateway(nextHop);
+  route->SetOutputDevice(m_egressDevice);
+  return route;
+}
+
+Ptr<Ipv4Route>
+Gpsr::GreedyRoute(Ipv4Address dst, Vector dstPos, Vector myPos)
+{
+  if (!m_egressDevice) {
+    return Ptr<Ipv4Route>();
+  }
+
+  // Spreading draws the next hop per packet, there is nothing to cache
+  if (m_neighbors.GetLoadTolerance() > 0) {
+    Ipv4Address nextHop = m_neighbors.BestNeighbor(dstPos, myPos);
+    return nextHop == Ipv4Address::GetZero() ? Ptr<Ipv4Route>() : MakeRoute(dst, nextHop);
+  }
+
+  // Expiry bumps the epoch as well, so purge before comparing it. Any
+  // change to the table or to our own position invalidates every entry.
+  m_neighbors.Purge();
+  if (m_routeCacheEpoch != m_neighbors.GetEpoch() || !(m_routeCachePos == myPos) ||
+      m_routeCache.size() >= GPSR_ROUTE_CACHE_MAX) {
+    m_routeCache.clear();
+    m_routeCacheEpoch = m_neighbors.GetEpoch();
+    m_routeCachePos = myPos;
+  }
+
+  // Entries are per destination address, so a route always leads to its
+  // own destination. With exact positions a hit is what BestNeighbor
+  // would return; buckets trade that for hits on moving destinations.
+  std::unordered_map<uint32_t, RouteCacheEntry>::const_iterator i = m_routeCache.find(dst.Get());
+  if (i != m_routeCache.end()) {
+    const Vector &cached = i->second.dstPos;
+    bool hit;
+    if (m_routeCacheBucket > 0) {
+      hit = std::floor(cached.x / m_routeCacheBucket) == std::floor(dstPos.x / m_routeCacheBucket) &&
+            std::floor(cached.y / m_routeCacheBucket) == std::floor(dstPos.y / m_routeCacheBucket);
+    } else {
+      hit = cached.x == dstPos.x && cached.y == dstPos.y;
+    }
+    if (hit) {
+      ++m_routeCacheHits;
+      return i->second.route;
     }
+  }
+  ++m_routeCacheMisses;
+
+  // Failures are cached too (as a null route), they send the packet to
+  // recovery without another scan
+  Ipv4Address nextHop = m_neighbors.BestNeighbor(dstPos, myPos);
+  Ptr<Ipv4Route> route = nextHop == Ipv4Address::GetZero() ? Ptr<Ipv4Route>() : MakeRoute(dst, nextHop);
+  m_routeCache[dst.Get()] = RouteCacheEntry{dstPos, route};
+  return route;
+}
+
+void
+Gpsr::CountHop(Ptr<const Packet> p, bool perimeter)
+{
+  // Tags belong to the packet object and are copied on write, and every
+  // caller hands over a packet no one else sends, so the counts are
+  // updated in place instead of on another copy
+  Ptr<Packet> packet = ConstCast<Packet>(p);
+  GpsrHopsTag tag;
+  packet->RemovePacketTag(tag);
+  tag.CountHop(perimeter);
+  packet->AddPacketTag(tag);
+}
+
+void
+Gpsr::SendData(const UnicastForwardCallback &ucb, Ptr<Ipv4Route> route, Ptr<const Packet> p, Ipv4Header header)
+{
+  GpsrPositionTag positionTag;
+  if (p->PeekPacketTag(positionTag)) {
+    m_dataHeaderBytes += GpsrPositionHeader::PeekSerializedSize(p);
+  }
+  ++m_dataTx;
+  if (m_helloLoad) {
+    SampleLoad();
+  }
+
+  if (m_piggybackPosition) {
+    Ptr<Packet> packet = p->Copy();
+    ++m_packetCopies;
+    m_dataHeaderBytes += PutSenderHeader(packet, route->GetSource());
+    header.SetPayloadSize(packet->GetSize());
+    ucb(route, packet, header);
+    return;
+  }
+  ucb(route, p, header);
+}
+
+uint32_t
+Gpsr::PutSenderHeader(Ptr<Packet> packet, Ipv4Address sender)
+{
+  Vector myPos;
+  if (!GetMyPosition(myPos)) {
+    return 0;
+  }
+
+  GpsrSenderHeader senderHeader(sender, myPos.x, myPos.y);
+  packet->AddHeader(senderHeader);
+  packet->AddPacketTag(GpsrSenderTag());
+
+  ++m_piggybackTx;
+  m_lastAdvertPos = myPos;
+  m_lastAdvertTime = Simulator::Now();
+  m_advertised = true;
+  return senderHeader.GetSerializedSize();
+}
+
+Ptr<Packet>
+Gpsr::StripSenderHeader(Ptr<const Packet> p, Ipv4Header &header)
+{
+  Ptr<Packet> packet = p->Copy();
+  ++m_packetCopies;
+  GpsrSenderTag senderTag;
+  if (packet->RemovePacketTag(senderTag)) {
+    packet->RemoveAtStart(GpsrSenderHeader().GetSerializedSize());
+    header.SetPayloadSize(packet->GetSize());
+  }
+  return packet;
+}
+
+void
+Gpsr::OverhearData(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                   const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  GpsrSenderTag senderTag;
+  if (device != m_egressDevice || !packet->PeekPacketTag(senderTag)) {
+    return;
+  }
 
-    // Add GpsrPositionHeader
-    GpsrPositionHeader gpsrHeader;
-    gpsrHeader.SetDstPositionX(dstPos.x);
-    gpsrHeader.SetDstPositionY(dstPos.y);
-    // Initialize other fields for a packet originating from source (not yet in recovery)
-    gpsrHeader.SetRecPositionX(0); // Not in recovery yet
-    gpsrHeader.SetRecPositionY(0);
-    gpsrHeader.SetPrevPositionX(0); // No previous hop yet
-    gpsrHeader.SetPrevPositionY(0);
-    gpsrHeader.SetRecoveryFlag(false); // Not in recovery
-    // TODO: Ensure GpsrPositionHeader has these fields and setters.
+  // The frame still starts with its IP header
+  Ptr<Packet> frame = packet->Copy();
+  ++m_packetCopies;
+  Ipv4Header ipHeader;
+  frame->RemoveHeader(ipHeader);
+  GpsrSenderHeader senderHeader;
+  frame->RemoveHeader(senderHeader);
+  if (IsMyOwnAddress(senderHeader.GetSender())) {
+    return;
+  }
 
-    p->AddHeader(gpsrHeader);
+  NS_LOG_LOGIC("OverhearData: " << senderHeader.GetSender() << " advertised " << senderHeader);
+  ++m_piggybackRx;
+  UpdateRouteToNeighbor(senderHeader.GetSender(),
+                        Vector(senderHeader.GetPositionX(), senderHeader.GetPositionY(), 0));
 }
 
-} // namespace ns3
\ No newline at end of file
+} // namespace ns3
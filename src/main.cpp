@@ -1,17 +1,83 @@
 #include "ns3/core-module.h"
 #include "Simulations/StaticSimulation.hpp"
 #include "Simulations/StaticSimulationGPSR.hpp"
+#include "Simulations/PtableBenchmark.hpp"
 
 int main(int argc, char *argv[]) {
     // Parse command line
     ns3::CommandLine cmd;
     std::string protocol = "GPSR";  // Default to GPSR
     bool debug = false;
+    int numNodes = 10;
+    double simulationTime = 30.0;
+    uint32_t packetSize = 512;
+    std::string headerFormat = "Raw";
+    std::string dataHeader = "Full";
+    std::string topology = "Grid";
+    std::string mobility = "Static";
+    double speed = 5.0;
+    std::string helloMode = "Fixed";
+    double helloInterval = 1.0;
+    bool prediction = false;
+    bool piggyback = false;
+    bool linkFeedback = false;
+    std::string metric = "Distance";
+    uint32_t flows = 1;
+    double flowInterval = 1.0;
+    bool helloLoad = false;
+    double loadTolerance = 0.0;
+    uint32_t maxPerimeterHops = 0;
+    bool perimeterLoopDetection = false;
+    double beaconSlot = 0.0;
+    double oracleRange = 0.0;
+    std::string channel = "Yans";
+    double channelCutoff = 0.0;
+    bool benchmark = false;
 
     cmd.AddValue("protocol", "Routing protocol to use (DSDV, GPSR)", protocol);
     cmd.AddValue("debug", "Enable debug mode with verbose logging", debug);
+    cmd.AddValue("nodes", "Number of nodes in the simulation", numNodes);
+    cmd.AddValue("time", "Simulation duration in seconds", simulationTime);
+    cmd.AddValue("packetSize", "Echo packet payload size in bytes", packetSize);
+    cmd.AddValue("headerFormat", "GPSR header encoding (Raw, Compact)", headerFormat);
+    cmd.AddValue("dataHeader", "GPSR header on greedy data packets (Full, Stub, None)", dataHeader);
+    cmd.AddValue("topology", "Node placement (Grid, Void, Random)", topology);
+    cmd.AddValue("mobility", "Node movement (Static, RandomWaypoint)", mobility);
+    cmd.AddValue("speed", "Random waypoint speed in m/s", speed);
+    cmd.AddValue("helloMode", "GPSR HELLO beaconing (Fixed, Adaptive, Off)", helloMode);
+    cmd.AddValue("helloInterval", "GPSR HELLO interval in seconds", helloInterval);
+    cmd.AddValue("prediction", "Send velocity in HELLOs and extrapolate neighbor positions", prediction);
+    cmd.AddValue("piggyback", "Carry the sender position on data frames and skip HELLOs while they do", piggyback);
+    cmd.AddValue("linkFeedback", "Evict neighbors and reroute when the MAC gives up on a frame", linkFeedback);
+    cmd.AddValue("metric", "GPSR greedy metric (Distance, PrrDistance, EtxProgress)", metric);
+    cmd.AddValue("flows", "Number of concurrent echo flows, node i to node nodes - 1 - i", flows);
+    cmd.AddValue("flowInterval", "Time between the packets of each flow in seconds", flowInterval);
+    cmd.AddValue("helloLoad", "Advertise the MAC queue occupancy in HELLOs", helloLoad);
+    cmd.AddValue("loadTolerance", "Spread greedy traffic over neighbors within this fraction of the best, by load", loadTolerance);
+    cmd.AddValue("maxPerimeterHops", "Perimeter hops a packet may take per recovery, 0 for no limit", maxPerimeterHops);
+    cmd.AddValue("perimeterLoopDetection", "Drop perimeter packets about to repeat the first edge of their face", perimeterLoopDetection);
+    cmd.AddValue("beaconSlot", "Batch all nodes' HELLOs into shared slots of this many seconds, 0 for a timer per node", beaconSlot);
+    cmd.AddValue("oracleRange", "Fill static nodes' neighbor tables from true positions within this range in metres, 0 to use HELLOs", oracleRange);
+    cmd.AddValue("channel", "WiFi channel (Yans, Spatial)", channel);
+    cmd.AddValue("channelCutoff", "Spatial channel reception cutoff in metres, 0 for the receive sensitivity range", channelCutoff);
+    cmd.AddValue("benchmark", "Time BestNeighbor and IsNeighbor on each neighbor table backend instead of simulating", benchmark);
     cmd.Parse(argc, argv);
 
+    ns3::GlobalValue::Bind("GpsrHeaderFormat", ns3::StringValue(headerFormat));
+    ns3::Config::SetDefault("ns3::Gpsr::DataHeader", ns3::StringValue(dataHeader));
+    ns3::Config::SetDefault("ns3::Gpsr::HelloMode", ns3::StringValue(helloMode));
+    ns3::Config::SetDefault("ns3::Gpsr::HelloInterval", ns3::TimeValue(ns3::Seconds(helloInterval)));
+    ns3::Config::SetDefault("ns3::Gpsr::HelloMotion", ns3::BooleanValue(prediction));
+    ns3::Config::SetDefault("ns3::Gpsr::PositionPrediction", ns3::BooleanValue(prediction));
+    ns3::Config::SetDefault("ns3::Gpsr::PiggybackPosition", ns3::BooleanValue(piggyback));
+    ns3::Config::SetDefault("ns3::Gpsr::LinkFailureFeedback", ns3::BooleanValue(linkFeedback));
+    ns3::Config::SetDefault("ns3::Gpsr::ForwardingMetric", ns3::StringValue(metric));
+    ns3::Config::SetDefault("ns3::Gpsr::HelloLoad", ns3::BooleanValue(helloLoad));
+    ns3::Config::SetDefault("ns3::Gpsr::LoadTolerance", ns3::DoubleValue(loadTolerance));
+    ns3::Config::SetDefault("ns3::Gpsr::MaxPerimeterHops", ns3::UintegerValue(maxPerimeterHops));
+    ns3::Config::SetDefault("ns3::Gpsr::PerimeterLoopDetection", ns3::BooleanValue(perimeterLoopDetection));
+    ns3::Config::SetDefault("ns3::Gpsr::BeaconSlot", ns3::TimeValue(ns3::Seconds(beaconSlot)));
+
     // Set up logging with reduced verbosity
     if (debug) {
         // Only enable selective components if debug is requested
@@ -27,15 +93,20 @@ int main(int argc, char *argv[]) {
         ns3::LogComponentEnable("GpsrPtable", LOG_LEVEL_WARN);
     }
 
+    if (benchmark) {
+        return PtableBenchmark().Run() ? 0 : 1;
+    }
+
     try {
         // Create and run the appropriate simulation
         if (protocol == "GPSR") {
             std::cout << "Running GPSR routing simulation...\n";
-            StaticSimulationGPSR sim(10, 30.0);  // 10 nodes, 30 seconds
+            StaticSimulationGPSR sim(numNodes, simulationTime, packetSize, topology, mobility, speed,
+                                     flows, flowInterval, oracleRange, channel, channelCutoff);
             sim.Run();
         } else {
             std::cout << "Running " << protocol << " routing simulation...\n";
-            StaticSimulation sim(10, 30.0, "DSDV");
+            StaticSimulation sim(numNodes, simulationTime, "DSDV");
             sim.Run();
         }
     } catch (const std::exception& e) {
@@ -0,0 +1,97 @@
+#include "Simulations/PtableBenchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace ns3;
+
+// Neighbors are placed in a square of this half-width around the node,
+// destinations in one four times as wide
+#define BENCHMARK_RANGE 250.0
+
+// Distinct destinations and addresses cycled through by the queries
+#define BENCHMARK_QUERIES 1024
+
+// Neighbor entries visited by BestNeighbor per size, and IsNeighbor calls
+#define BENCHMARK_BEST_WORK (1u << 24)
+#define BENCHMARK_LOOKUPS (1u << 20)
+
+PtableBenchmark::PtableBenchmark(const std::vector<uint32_t> &sizes, uint32_t seed)
+    : m_sizes(sizes),
+      m_seed(seed) {
+}
+
+bool PtableBenchmark::Run() {
+    std::cout << "*** GPSR Neighbor Table Benchmark ***\n";
+    std::cout << std::setw(10) << "Neighbors" << std::setw(8) << "Backend"
+              << std::setw(20) << "BestNeighbor ns" << std::setw(18) << "IsNeighbor ns" << "\n";
+
+    bool agree = true;
+    for (uint32_t size : m_sizes) {
+        uint64_t mapChecksum = 0;
+        uint64_t flatChecksum = 0;
+        std::pair<double, double> map = Measure(GpsrPtable::MAP_BACKEND, size, mapChecksum);
+        std::pair<double, double> flat = Measure(GpsrPtable::FLAT_BACKEND, size, flatChecksum);
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(10) << size << std::setw(8) << "Map"
+                  << std::setw(20) << map.first << std::setw(18) << map.second << "\n"
+                  << std::setw(10) << size << std::setw(8) << "Flat"
+                  << std::setw(20) << flat.first << std::setw(18) << flat.second << "\n";
+        if (mapChecksum != flatChecksum) {
+            std::cerr << "Backends disagree at " << size << " neighbors\n";
+            agree = false;
+        }
+    }
+    return agree;
+}
+
+std::pair<double, double> PtableBenchmark::Measure(GpsrPtable::Backend backend, uint32_t size, uint64_t &checksum) {
+    // Same neighbors and queries for every backend at a size
+    std::mt19937 random(m_seed + size);
+    std::uniform_real_distribution<double> near(-BENCHMARK_RANGE, BENCHMARK_RANGE);
+    std::uniform_real_distribution<double> far(-4 * BENCHMARK_RANGE, 4 * BENCHMARK_RANGE);
+
+    // Addresses are inserted out of order, every other one is left out so
+    // that half of the lookups miss
+    std::vector<uint32_t> addresses(size);
+    for (uint32_t i = 0; i < size; i++) {
+        addresses[i] = Ipv4Address("10.0.0.0").Get() + 2 * i + 1;
+    }
+    std::shuffle(addresses.begin(), addresses.end(), random);
+
+    Ptr<GpsrPtable> table = CreateObject<GpsrPtable>();
+    table->SetBackend(backend);
+    for (uint32_t address : addresses) {
+        double x = near(random);
+        double y = near(random);
+        table->AddEntry(Ipv4Address(address), Vector(x, y, 0.0));
+    }
+
+    std::vector<Vector> destinations;
+    std::vector<Ipv4Address> lookups;
+    for (uint32_t i = 0; i < BENCHMARK_QUERIES; i++) {
+        double x = far(random);
+        double y = far(random);
+        destinations.push_back(Vector(x, y, 0.0));
+        lookups.push_back(Ipv4Address(Ipv4Address("10.0.0.0").Get() + random() % (2 * size) + 1));
+    }
+
+    const Vector nodePos(0.0, 0.0, 0.0);
+    const uint32_t bestCalls = std::max<uint32_t>(BENCHMARK_QUERIES, BENCHMARK_BEST_WORK / size);
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < bestCalls; i++) {
+        checksum += table->BestNeighbor(destinations[i % BENCHMARK_QUERIES], nodePos).Get();
+    }
+    std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_LOOKUPS; i++) {
+        checksum += table->IsNeighbor(lookups[i % BENCHMARK_QUERIES]) ? 1 : 0;
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    double best = std::chrono::duration_cast<std::chrono::nanoseconds>(middle - begin).count();
+    double lookup = std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count();
+    return std::make_pair(best / bestCalls, lookup / BENCHMARK_LOOKUPS);
+}
@@ -0,0 +1,228 @@
+#include "Simulations/SpatialWifiChannel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+NS_LOG_COMPONENT_DEFINE("SpatialWifiChannel");
+
+using namespace ns3;
+
+// Frames are assumed to reach no farther than this when searching for the
+// sensitivity range
+#define SPATIAL_MAX_RANGE 1e6
+
+SpatialWifiChannel::SpatialWifiChannel(const NetDeviceContainer &devices, double cutoff, Time refresh,
+                                       double margin)
+    : m_cutoff(cutoff),
+      m_refresh(refresh),
+      m_channelCount(0) {
+    for (uint32_t i = 0; i < devices.GetN(); i++) {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(devices.Get(i));
+        Ptr<YansWifiPhy> phy = device ? DynamicCast<YansWifiPhy>(device->GetPhy()) : nullptr;
+        Ptr<MobilityModel> mobility = device ? device->GetNode()->GetObject<MobilityModel>() : nullptr;
+        if (!phy || !mobility) {
+            throw std::invalid_argument("Spatial channel needs Yans WiFi devices on nodes with a mobility model");
+        }
+
+        // Frames keep the loss and delay of the channel the devices were
+        // installed on
+        if (!m_loss) {
+            Ptr<YansWifiChannel> original = DynamicCast<YansWifiChannel>(phy->GetChannel());
+            PointerValue loss;
+            PointerValue delay;
+            original->GetAttribute("PropagationLossModel", loss);
+            original->GetAttribute("PropagationDelayModel", delay);
+            m_loss = loss.Get<PropagationLossModel>();
+            m_delay = delay.Get<PropagationDelayModel>();
+        }
+
+        m_phys.push_back(phy);
+        m_mobility.push_back(mobility);
+    }
+
+    if (m_cutoff <= 0) {
+        for (uint32_t i = 0; i < m_phys.size(); i++) {
+            m_cutoff = std::max(m_cutoff, SensitivityRange(m_phys[i]));
+        }
+    }
+    m_cutoff += std::max(margin, 0.0);
+    NS_LOG_INFO("Spatial channel for " << m_phys.size() << " devices, cutoff " << m_cutoff << " m");
+
+    m_channels.resize(m_phys.size());
+    m_receivers.resize(m_phys.size());
+    m_cellOf.resize(m_phys.size());
+    Index();
+    for (uint32_t i = 0; i < m_phys.size(); i++) {
+        Rebuild(i, Nearby(m_mobility[i]->GetPosition()));
+    }
+
+    for (uint32_t i = 0; i < m_mobility.size(); i++) {
+        m_mobility[i]->TraceConnectWithoutContext("CourseChange",
+                                                  MakeCallback(&SpatialWifiChannel::CourseChanged, this).Bind(i));
+    }
+    if (m_refresh.IsStrictlyPositive()) {
+        Simulator::Schedule(m_refresh, &SpatialWifiChannel::Refresh, this);
+    }
+}
+
+double SpatialWifiChannel::GetCutoff() const {
+    return m_cutoff;
+}
+
+double SpatialWifiChannel::GetMeanReceivers() const {
+    if (m_receivers.empty()) {
+        return 0.0;
+    }
+    uint64_t receivers = 0;
+    for (uint32_t i = 0; i < m_receivers.size(); i++) {
+        // The sender is on its own channel too
+        receivers += m_receivers[i].size() - 1;
+    }
+    return static_cast<double>(receivers) / m_receivers.size();
+}
+
+uint64_t SpatialWifiChannel::GetChannelCount() const {
+    return m_channelCount;
+}
+
+double SpatialWifiChannel::SensitivityRange(Ptr<YansWifiPhy> phy) const {
+    // Yans drops a frame on arrival when the received power plus the
+    // receiver gain is below the sensitivity
+    const double txPower = phy->GetTxPowerEnd() + phy->GetTxGain();
+    const double threshold = phy->GetRxSensitivity() - phy->GetRxGain();
+
+    Ptr<ConstantPositionMobilityModel> sender = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> receiver = CreateObject<ConstantPositionMobilityModel>();
+    auto heard = [&](double distance) {
+        receiver->SetPosition(Vector(distance, 0.0, 0.0));
+        return m_loss->CalcRxPower(txPower, sender, receiver) >= threshold;
+    };
+
+    // Loss grows with distance, so double until the frame is lost and
+    // bisect the last step
+    double low = 0.0;
+    double high = 1.0;
+    while (heard(high)) {
+        low = high;
+        high *= 2;
+        if (high > SPATIAL_MAX_RANGE) {
+            NS_LOG_WARN("Frames are heard beyond " << SPATIAL_MAX_RANGE << " m, the spatial channel will not help");
+            return high;
+        }
+    }
+    for (int step = 0; step < 40; step++) {
+        double middle = (low + high) / 2;
+        if (heard(middle)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return high;
+}
+
+uint64_t SpatialWifiChannel::CellOf(const Vector &position) const {
+    // The two cell coordinates as 32-bit halves of one key
+    int64_t x = static_cast<int64_t>(std::floor(position.x / m_cutoff));
+    int64_t y = static_cast<int64_t>(std::floor(position.y / m_cutoff));
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+std::vector<uint32_t> SpatialWifiChannel::Nearby(const Vector &position) const {
+    std::vector<uint32_t> nearby;
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            Vector corner(position.x + dx * m_cutoff, position.y + dy * m_cutoff, 0.0);
+            auto cell = m_cells.find(CellOf(corner));
+            if (cell == m_cells.end()) {
+                continue;
+            }
+            for (uint32_t j : cell->second) {
+                if (CalculateDistance(position, m_mobility[j]->GetPosition()) <= m_cutoff) {
+                    nearby.push_back(j);
+                }
+            }
+        }
+    }
+    return nearby;
+}
+
+void SpatialWifiChannel::Rebuild(uint32_t i, const std::vector<uint32_t> &nearby) {
+    Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel>();
+    channel->SetPropagationLossModel(m_loss);
+    channel->SetPropagationDelayModel(m_delay);
+    ++m_channelCount;
+
+    m_receivers[i].clear();
+    for (uint32_t j : nearby) {
+        if (j != i) {
+            channel->Add(m_phys[j]);
+            m_receivers[i].insert(j);
+        }
+    }
+
+    // Frames already on the air keep their scheduled receptions
+    m_phys[i]->SetChannel(channel);
+    m_receivers[i].insert(i);
+    m_channels[i] = channel;
+}
+
+void SpatialWifiChannel::Update(uint32_t i) {
+    std::vector<uint32_t> nearby = Nearby(m_mobility[i]->GetPosition());
+    std::size_t inRange = 0;
+    for (uint32_t j : nearby) {
+        if (j == i) {
+            continue;
+        }
+        ++inRange;
+        if (m_receivers[i].insert(j).second) {
+            m_channels[i]->Add(m_phys[j]);
+        }
+    }
+
+    // The receivers include i itself
+    std::size_t stale = m_receivers[i].size() - 1 - inRange;
+    if (stale > inRange) {
+        NS_LOG_LOGIC("Replacing the channel of PHY " << i << ", " << stale << " of its receivers left the cutoff");
+        Rebuild(i, nearby);
+    }
+}
+
+void SpatialWifiChannel::Index() {
+    m_cells.clear();
+    for (uint32_t i = 0; i < m_phys.size(); i++) {
+        m_cellOf[i] = CellOf(m_mobility[i]->GetPosition());
+        m_cells[m_cellOf[i]].push_back(i);
+    }
+}
+
+void SpatialWifiChannel::Refresh() {
+    Index();
+    for (uint32_t i = 0; i < m_phys.size(); i++) {
+        Update(i);
+    }
+    Simulator::Schedule(m_refresh, &SpatialWifiChannel::Refresh, this);
+}
+
+void SpatialWifiChannel::CourseChanged(uint32_t i, Ptr<const MobilityModel> mobility) {
+    // Move the node to its new cell
+    uint64_t cell = CellOf(mobility->GetPosition());
+    if (cell != m_cellOf[i]) {
+        std::vector<uint32_t> &old = m_cells[m_cellOf[i]];
+        old.erase(std::find(old.begin(), old.end(), i));
+        if (old.empty()) {
+            m_cells.erase(m_cellOf[i]);
+        }
+        m_cellOf[i] = cell;
+        m_cells[cell].push_back(i);
+    }
+
+    // It hears and is heard by the nodes it is now near. The ones it
+    // left keep it until their channels are replaced.
+    Update(i);
+    for (uint32_t j : Nearby(mobility->GetPosition())) {
+        if (m_receivers[j].insert(i).second) {
+            m_channels[j]->Add(m_phys[i]);
+        }
+    }
+}
@@ -14,13 +14,39 @@
 #include "ns3/names.h"
 #include "ns3/trace-helper.h"
 #include "ns3/packet-sink-helper.h"
+#include "ns3/enum.h"
+#include "ns3/pointer.h"
+#include "ns3/simulation-singleton.h"
+#include "gpsr/gpsr-beacon.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 NS_LOG_COMPONENT_DEFINE("StaticSimulationGPSR");
 
-StaticSimulationGPSR::StaticSimulationGPSR(const int numNodes, const double simulationTime) {
+// All nodes share one subnet, a /8 so that the large sweeps fit in it
+#define GPSR_SUBNET_BASE "10.0.0.0"
+#define GPSR_SUBNET_MASK "255.0.0.0"
+
+StaticSimulationGPSR::StaticSimulationGPSR(const int numNodes, const double simulationTime, const uint32_t packetSize,
+                                           const std::string &topology, const std::string &mobility,
+                                           const double speed, const uint32_t flows, const double flowInterval,
+                                           const double oracleRange, const std::string &channel,
+                                           const double channelCutoff) {
     m_numNodes = numNodes;
+    m_flows = flows;
+    m_flowInterval = flowInterval;
+    m_packetSize = packetSize;
+    m_mobility = mobility;
+    m_speed = speed;
+    m_wallTime = 0.0;
+    m_oracleRange = oracleRange;
+    m_oracleEntries = 0;
+    m_channel = channel;
+    m_channelCutoff = channelCutoff;
     m_simulationTime = simulationTime;
     m_routingProtocol = "GPSR";
+    m_topology = topology;
 }
 
 StaticSimulationGPSR::~StaticSimulationGPSR() {}
@@ -32,17 +58,66 @@ void StaticSimulationGPSR::SetupTopology() {
 
     // IMPORTANT FIX: Reduce node spacing to ensure nodes are within radio range
     // Default WiFi range is around 100-150m, so node spacing should be < 100m
-    mobility.SetPositionAllocator("ns3::GridPositionAllocator",
-                               "MinX", ns3::DoubleValue(0.0),
-                               "MinY", ns3::DoubleValue(0.0),
-                               "DeltaX", ns3::DoubleValue(100.0),  // Changed from 120.0 to 100.0
-                               "DeltaY", ns3::DoubleValue(100.0),  // Changed from 120.0 to 100.0
-                               "GridWidth", ns3::UintegerValue(5),
-                               "LayoutType", ns3::StringValue("RowFirst"));
-
-    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    if (m_topology == "Void") {
+        // The grid with a 3 x 3 block of cells left empty in the middle of
+        // its first five rows, so flows across it need perimeter mode
+        Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+        for (uint32_t cell = 0, placed = 0; placed < static_cast<uint32_t>(m_numNodes); cell++) {
+            const uint32_t column = cell % 5;
+            const uint32_t row = cell / 5;
+            if (column >= 1 && column <= 3 && row >= 1 && row <= 3) {
+                continue;
+            }
+            positions->Add(Vector(100.0 * column, 100.0 * row, 0.0));
+            placed++;
+        }
+        mobility.SetPositionAllocator(positions);
+    } else if (m_topology == "Random") {
+        // Same density as the grid: one node per 100 m x 100 m cell on average
+        std::ostringstream side;
+        side << "ns3::UniformRandomVariable[Min=0.0|Max=" << 100.0 * std::ceil(std::sqrt(m_numNodes)) << "]";
+        mobility.SetPositionAllocator("ns3::RandomRectanglePositionAllocator",
+                                   "X", ns3::StringValue(side.str()),
+                                   "Y", ns3::StringValue(side.str()));
+    } else {
+        mobility.SetPositionAllocator("ns3::GridPositionAllocator",
+                                   "MinX", ns3::DoubleValue(0.0),
+                                   "MinY", ns3::DoubleValue(0.0),
+                                   "DeltaX", ns3::DoubleValue(100.0),  // Changed from 120.0 to 100.0
+                                   "DeltaY", ns3::DoubleValue(100.0),  // Changed from 120.0 to 100.0
+                                   "GridWidth", ns3::UintegerValue(5),
+                                   "LayoutType", ns3::StringValue("RowFirst"));
+    }
+
+    if (m_mobility == "RandomWaypoint") {
+        // Waypoints over the same area the random topology is drawn from
+        const double side = 100.0 * std::ceil(std::sqrt(m_numNodes));
+        Ptr<RandomRectanglePositionAllocator> waypoints = CreateObject<RandomRectanglePositionAllocator>();
+        waypoints->SetX(CreateObjectWithAttributes<UniformRandomVariable>("Min", DoubleValue(0.0), "Max", DoubleValue(side)));
+        waypoints->SetY(CreateObjectWithAttributes<UniformRandomVariable>("Min", DoubleValue(0.0), "Max", DoubleValue(side)));
+
+        std::ostringstream speed;
+        speed << "ns3::ConstantRandomVariable[Constant=" << m_speed << "]";
+        mobility.SetMobilityModel("ns3::RandomWaypointMobilityModel",
+                                  "Speed", ns3::StringValue(speed.str()),
+                                  "Pause", ns3::StringValue("ns3::ConstantRandomVariable[Constant=0.0]"),
+                                  "PositionAllocator", ns3::PointerValue(waypoints));
+    } else {
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    }
     mobility.Install(m_nodes);
 
+    // Moving nodes drift between course changes, so their channels are
+    // also updated every second, and the cutoff grows by the distance two
+    // nodes heading for each other cover in that second. Frames within the
+    // requested cutoff then reach the same receivers as on Yans.
+    if (m_channel == "Spatial") {
+        const bool moving = m_mobility == "RandomWaypoint";
+        const Time refresh = moving ? Seconds(1.0) : Seconds(0);
+        const double margin = moving ? 2 * m_speed * refresh.GetSeconds() : 0.0;
+        m_spatialChannel = std::make_unique<SpatialWifiChannel>(m_devices, m_channelCutoff, refresh, margin);
+    }
+
     // Log node positions but with less verbosity
     NS_LOG_INFO("Node positions:");
     for (uint32_t i = 0; i < m_nodes.GetN(); i++) {
@@ -69,9 +144,8 @@ void StaticSimulationGPSR::SetupRoutingProtocol() {
     // Create and configure GPSR helper
     GpsrHelper gpsr;
 
-    // IMPORTANT: Set GPSR parameters
-    // Increase hello interval for faster neighbor discovery
-    gpsr.Set("HelloInterval", TimeValue(Seconds(1.0)));
+    // GPSR parameters (HelloInterval, HelloMode, ...) come from the
+    // ns3::Gpsr defaults, which main.cpp sets from the command line
 
     // Install internet stack with GPSR routing
     InternetStackHelper internet;
@@ -79,8 +153,15 @@ void StaticSimulationGPSR::SetupRoutingProtocol() {
     internet.Install(m_nodes);
 
     // Configure IP addressing
+    // The network and broadcast addresses are not handed out
+    Ipv4Mask mask(GPSR_SUBNET_MASK);
+    uint32_t hosts = ~mask.Get() - 1;
+    if (m_devices.GetN() > hosts) {
+        NS_FATAL_ERROR(m_devices.GetN() << " nodes do not fit the " << GPSR_SUBNET_BASE << "/" << mask.GetPrefixLength()
+                       << " subnet of " << hosts << " hosts");
+    }
     Ipv4AddressHelper ipv4;
-    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4.SetBase(GPSR_SUBNET_BASE, mask);
     m_interfaces = ipv4.Assign(m_devices);
 
     // Log IP addresses with less verbosity
@@ -89,6 +170,16 @@ void StaticSimulationGPSR::SetupRoutingProtocol() {
         NS_LOG_INFO("Node " << i << ": " << m_interfaces.GetAddress(i));
     }
 
+    // Static nodes can skip neighbor discovery altogether
+    if (m_oracleRange > 0) {
+        if (m_mobility == "Static") {
+            m_oracleEntries = GpsrHelper::PopulateNeighbors(m_nodes, m_oracleRange);
+        } else {
+            NS_LOG_WARN("Neighbor oracle needs static nodes, discovering neighbors by HELLOs");
+            m_oracleRange = 0;
+        }
+    }
+
     // Install flow monitoring
     m_flowMonitor = m_flowHelper.InstallAll();
 
@@ -109,23 +200,31 @@ void StaticSimulationGPSR::ConfigureApplications() {
     // Use a simpler UDP echo server/client application
     uint16_t port = 9;
 
-    // Create server on last node (node 9)
-    UdpEchoServerHelper echoServer(port);
-    ApplicationContainer serverApps = echoServer.Install(m_nodes.Get(m_numNodes - 1));
-    serverApps.Start(Seconds(5.0));  // Start later to allow neighbor discovery
-    serverApps.Stop(Seconds(m_simulationTime));
-
-    // Create client on first node (node 0)
-    UdpEchoClientHelper echoClient(m_interfaces.GetAddress(m_numNodes - 1), port);
-    echoClient.SetAttribute("MaxPackets", UintegerValue(200));
-    echoClient.SetAttribute("Interval", TimeValue(Seconds(1.0))); // Send slower
-    echoClient.SetAttribute("PacketSize", UintegerValue(512));
-
-    ApplicationContainer clientApps = echoClient.Install(m_nodes.Get(0));
-    clientApps.Start(Seconds(10.0));  // Start even later to allow neighbor discovery
-    clientApps.Stop(Seconds(m_simulationTime - 1.0));
-
-    NS_LOG_INFO("Configured UDP Echo client on node 0 sending to node " << (m_numNodes - 1));
+    // Flow i runs from node i to node numNodes - 1 - i, so on the grid all
+    // flows cross the middle of the field. Each node is in at most one flow.
+    // Tables filled by the oracle need no time to converge.
+    const double serverStart = m_oracleRange > 0 ? 0.5 : 5.0;
+    const double clientStart = m_oracleRange > 0 ? 1.0 : 10.0;
+    const uint32_t flows = std::max<uint32_t>(1, std::min<uint32_t>(m_flows, m_numNodes / 2));
+    for (uint32_t i = 0; i < flows; i++) {
+        const uint32_t server = m_numNodes - 1 - i;
+
+        UdpEchoServerHelper echoServer(port);
+        ApplicationContainer serverApps = echoServer.Install(m_nodes.Get(server));
+        serverApps.Start(Seconds(serverStart));  // Start later to allow neighbor discovery
+        serverApps.Stop(Seconds(m_simulationTime));
+
+        UdpEchoClientHelper echoClient(m_interfaces.GetAddress(server), port);
+        echoClient.SetAttribute("MaxPackets", UintegerValue(static_cast<uint32_t>(std::ceil(m_simulationTime / m_flowInterval))));
+        echoClient.SetAttribute("Interval", TimeValue(Seconds(m_flowInterval)));
+        echoClient.SetAttribute("PacketSize", UintegerValue(m_packetSize));
+
+        ApplicationContainer clientApps = echoClient.Install(m_nodes.Get(i));
+        clientApps.Start(Seconds(clientStart));  // Start even later to allow neighbor discovery
+        clientApps.Stop(Seconds(m_simulationTime - 1.0));
+
+        NS_LOG_INFO("Configured UDP Echo client on node " << i << " sending to node " << server);
+    }
 }
 
 
@@ -143,7 +242,9 @@ void StaticSimulationGPSR::RunSimulation() {
 
     // Run the simulation
     Simulator::Stop(Seconds(m_simulationTime));
+    auto start = std::chrono::steady_clock::now();
     Simulator::Run();
+    m_wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
 void StaticSimulationGPSR::CaptureBriefState() {
@@ -192,9 +293,16 @@ void StaticSimulationGPSR::CollectResults() {
 
     uint32_t totalTxPackets = 0;
     uint32_t totalRxPackets = 0;
+    uint64_t totalRxBytes = 0;
+    Time firstTx = Seconds(m_simulationTime);
+    Time lastRx;
+    std::map<double, uint32_t> delayBins; // All flows' delay histograms, by bin start
 
     // Print flow statistics with less verbosity
     std::cout << "\n*** GPSR Routing Results ***\n";
+    std::cout << "Topology: " << m_topology << ", mobility: " << m_mobility
+              << ", header format: " << (ns3::GetGpsrHeaderFormat() == ns3::GPSR_FORMAT_COMPACT ? "Compact" : "Raw")
+              << ", packet size: " << m_packetSize << " bytes\n";
 
     if (stats.empty()) {
         std::cout << "ERROR: No flows detected in the simulation!\n";
@@ -203,13 +311,33 @@ void StaticSimulationGPSR::CollectResults() {
             Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(i->first);
             totalTxPackets += i->second.txPackets;
             totalRxPackets += i->second.rxPackets;
+            totalRxBytes += i->second.rxBytes;
+            if (i->second.rxPackets > 0) {
+                firstTx = std::min(firstTx, i->second.timeFirstTxPacket);
+                lastRx = std::max(lastRx, i->second.timeLastRxPacket);
+            }
 
             std::cout << "Flow " << i->first << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")\n";
             std::cout << "  Tx Packets: " << i->second.txPackets << "\n";
             std::cout << "  Rx Packets: " << i->second.rxPackets << "\n";
             if (i->second.rxPackets > 0) {
-                std::cout << "  Throughput: " << i->second.rxBytes * 8.0 / (i->second.timeLastRxPacket.GetSeconds() - i->second.timeFirstTxPacket.GetSeconds()) / 1000 << " Kbps\n";
+                double duration = i->second.timeLastRxPacket.GetSeconds() - i->second.timeFirstTxPacket.GetSeconds();
+                std::cout << "  Throughput: " << i->second.rxBytes * 8.0 / duration / 1000 << " Kbps\n";
+                // Application payload only, without IP/UDP/GPSR headers
+                std::cout << "  Goodput: " << i->second.rxPackets * m_packetSize * 8.0 / duration / 1000 << " Kbps\n";
                 std::cout << "  Mean Delay: " << i->second.delaySum.GetSeconds() / i->second.rxPackets << " seconds\n";
+                std::cout << "  Mean Hop Count: " << 1.0 + static_cast<double>(i->second.timesForwarded) / i->second.rxPackets << "\n";
+                // Delay distribution, the first packets of a flow are the ones
+                // that wait in the request queue for a neighbor
+                const Histogram &delays = i->second.delayHistogram;
+                std::cout << "  Delay Histogram (bin start s: packets):";
+                for (uint32_t bin = 0; bin < delays.GetNBins(); ++bin) {
+                    if (delays.GetBinCount(bin) > 0) {
+                        std::cout << " " << delays.GetBinStart(bin) << ": " << delays.GetBinCount(bin);
+                        delayBins[delays.GetBinStart(bin)] += delays.GetBinCount(bin);
+                    }
+                }
+                std::cout << "\n";
             }
             std::cout << "  Packet Loss: " << 100.0 * (i->second.txPackets - i->second.rxPackets) / i->second.txPackets << "%\n";
         }
@@ -221,8 +349,15 @@ void StaticSimulationGPSR::CollectResults() {
         if (totalTxPackets > 0) {
             std::cout << "Overall Packet Delivery Ratio: " << 100.0 * totalRxPackets / totalTxPackets << "%\n";
         }
+        if (lastRx > firstTx) {
+            std::cout << "Aggregate Throughput: " << totalRxBytes * 8.0 / (lastRx - firstTx).GetSeconds() / 1000 << " Kbps\n";
+        }
+        PrintDelayPercentiles(delayBins);
     }
 
+    PrintForwardingStats();
+    PrintControlStats();
+
     // Print node positions in a more compact way
     std::cout << "\n*** GPSR Routing Tables ***\n";
     std::cout << "Node positions and addresses:\n";
@@ -281,4 +416,183 @@ void StaticSimulationGPSR::PrintRoutingTables() {
             std::cout << " IP: unknown (no node)  Position: unknown\n";
         }
     }
-}
\ No newline at end of file
+}
+void StaticSimulationGPSR::PrintDelayPercentiles(const std::map<double, uint32_t> &delayBins) {
+    uint64_t packets = 0;
+    for (std::map<double, uint32_t>::const_iterator i = delayBins.begin(); i != delayBins.end(); ++i) {
+        packets += i->second;
+    }
+    if (packets == 0) {
+        return;
+    }
+
+    // Percentiles at histogram bin resolution, reported as the bin start
+    const double percentiles[] = {50.0, 95.0, 99.0};
+    std::cout << "Delay percentiles (s):";
+    for (double p : percentiles) {
+        uint64_t seen = 0;
+        for (std::map<double, uint32_t>::const_iterator i = delayBins.begin(); i != delayBins.end(); ++i) {
+            seen += i->second;
+            if (seen * 100.0 >= p * packets) {
+                std::cout << " p" << p << "=" << i->first;
+                break;
+            }
+        }
+    }
+    std::cout << "\n";
+}
+
+void StaticSimulationGPSR::PrintForwardingStats() {
+    uint64_t dataTx = 0;
+    uint64_t headerBytes = 0;
+    uint64_t forwarded = 0;
+    int64_t forwardingCpu = 0;
+    uint64_t packetCopies = 0;
+    uint64_t delivered = 0;
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t macRetries = 0;
+    uint64_t linkFailures = 0;
+    uint64_t rerouted = 0;
+    uint64_t reroutedDrops = 0;
+    uint64_t greedyHops = 0;
+    uint64_t perimeterHops = 0;
+    uint64_t modeSwitches = 0;
+    uint64_t deliveredGreedy = 0;
+    uint64_t deliveredPerimeter = 0;
+    uint64_t deliveredSwitches = 0;
+    uint64_t loopDrops = 0;
+    uint64_t budgetDrops = 0;
+    std::string dataHeader = "unknown";
+    std::string metric = "unknown";
+
+    for (uint32_t i = 0; i < m_nodes.GetN(); i++) {
+        Ptr<ns3::Gpsr> gpsr = m_nodes.Get(i)->GetObject<ns3::Gpsr>();
+        if (!gpsr) {
+            continue;
+        }
+        dataTx += gpsr->GetDataTxCount();
+        headerBytes += gpsr->GetDataHeaderBytes();
+        forwarded += gpsr->GetForwardedCount();
+        forwardingCpu += gpsr->GetForwardingCpuNanoSeconds();
+        packetCopies += gpsr->GetPacketCopyCount();
+        delivered += gpsr->GetDeliveredCount();
+        cacheHits += gpsr->GetRouteCacheHits();
+        cacheMisses += gpsr->GetRouteCacheMisses();
+        macRetries += gpsr->GetMacRetryCount();
+        linkFailures += gpsr->GetLinkFailureCount();
+        rerouted += gpsr->GetReroutedCount();
+        reroutedDrops += gpsr->GetReroutedDropCount();
+        greedyHops += gpsr->GetGreedyHopCount();
+        perimeterHops += gpsr->GetPerimeterHopCount();
+        modeSwitches += gpsr->GetModeSwitchCount();
+        deliveredGreedy += gpsr->GetDeliveredGreedyHops();
+        deliveredPerimeter += gpsr->GetDeliveredPerimeterHops();
+        deliveredSwitches += gpsr->GetDeliveredModeSwitches();
+        loopDrops += gpsr->GetPerimeterLoopDropCount();
+        budgetDrops += gpsr->GetPerimeterBudgetDropCount();
+
+        EnumValue<ns3::Gpsr::DataHeaderMode> mode;
+        gpsr->GetAttribute("DataHeader", mode);
+        dataHeader = mode.Get() == ns3::Gpsr::DATA_HEADER_NONE ? "None"
+                   : mode.Get() == ns3::Gpsr::DATA_HEADER_STUB ? "Stub" : "Full";
+        metric = gpsr->GetForwardingMetric() == ns3::GpsrPtable::METRIC_PRR_DISTANCE ? "PrrDistance"
+               : gpsr->GetForwardingMetric() == ns3::GpsrPtable::METRIC_ETX_PROGRESS ? "EtxProgress" : "Distance";
+    }
+
+    std::cout << "*** GPSR Forwarding ***\n";
+    std::cout << "Data header: " << dataHeader << ", greedy metric: " << metric << "\n";
+    std::cout << "Data transmissions: " << dataTx << "\n";
+    if (dataTx > 0) {
+        std::cout << "GPSR header bytes per transmission: " << static_cast<double>(headerBytes) / dataTx << "\n";
+    }
+    if (forwarded > 0) {
+        std::cout << "Forwarding CPU per packet: " << forwardingCpu / 1000.0 / forwarded << " us\n";
+    }
+    if (delivered > 0) {
+        std::cout << "Packet copies per delivered packet: " << static_cast<double>(packetCopies) / delivered << "\n";
+    }
+    if (cacheHits + cacheMisses > 0) {
+        std::cout << "Route cache hit rate: " << 100.0 * cacheHits / (cacheHits + cacheMisses) << "%\n";
+    }
+    std::cout << "Greedy hops: " << greedyHops << ", perimeter hops: " << perimeterHops
+              << ", mode switches: " << modeSwitches << "\n";
+    if (delivered > 0) {
+        // Counted on each packet, so hops of packets that were dropped
+        // later do not show up here
+        std::cout << "Per delivered packet: " << static_cast<double>(deliveredGreedy) / delivered
+                  << " greedy hops, " << static_cast<double>(deliveredPerimeter) / delivered
+                  << " perimeter hops, " << static_cast<double>(deliveredSwitches) / delivered
+                  << " mode switches\n";
+    }
+    std::cout << "Perimeter drops: " << loopDrops << " loops, " << budgetDrops << " over hop budget\n";
+    std::cout << "MAC retransmissions: " << macRetries << ", link failures: " << linkFailures
+              << ", rerouted: " << rerouted << " (" << reroutedDrops << " dropped)\n";
+}
+
+void StaticSimulationGPSR::PrintControlStats() {
+    uint64_t helloTx = 0;
+    uint64_t helloBytes = 0;
+    uint64_t helloSuppressed = 0;
+    uint64_t piggybackTx = 0;
+    uint64_t piggybackRx = 0;
+    std::string helloMode = "unknown";
+    Time helloInterval;
+    Time beaconSlot;
+    bool prediction = false;
+
+    for (uint32_t i = 0; i < m_nodes.GetN(); i++) {
+        Ptr<ns3::Gpsr> gpsr = m_nodes.Get(i)->GetObject<ns3::Gpsr>();
+        if (!gpsr) {
+            continue;
+        }
+        helloTx += gpsr->GetHelloTxCount();
+        helloBytes += gpsr->GetHelloBytes();
+        helloSuppressed += gpsr->GetHelloSuppressedCount();
+        piggybackTx += gpsr->GetPiggybackTxCount();
+        piggybackRx += gpsr->GetPiggybackRxCount();
+
+        EnumValue<ns3::Gpsr::HelloMode> mode;
+        gpsr->GetAttribute("HelloMode", mode);
+        helloMode = mode.Get() == ns3::Gpsr::HELLO_ADAPTIVE ? "Adaptive"
+                  : mode.Get() == ns3::Gpsr::HELLO_OFF ? "Off" : "Fixed";
+
+        TimeValue interval;
+        gpsr->GetAttribute("HelloInterval", interval);
+        helloInterval = interval.Get();
+        gpsr->GetAttribute("BeaconSlot", interval);
+        beaconSlot = interval.Get();
+        prediction = gpsr->GetPositionPrediction();
+    }
+
+    std::cout << "*** GPSR Control ***\n";
+    std::cout << "Hello mode: " << helloMode << ", interval: " << helloInterval.GetSeconds()
+              << " s, position prediction: " << (prediction ? "on" : "off") << "\n";
+    if (m_spatialChannel) {
+        std::cout << "Channel: Spatial, cutoff " << m_spatialChannel->GetCutoff() << " m, "
+                  << m_spatialChannel->GetMeanReceivers() << " receivers per sender, "
+                  << m_spatialChannel->GetChannelCount() << " channels created\n";
+    } else {
+        std::cout << "Channel: Yans\n";
+    }
+    if (m_oracleRange > 0) {
+        std::cout << "Neighbor oracle: " << m_oracleEntries << " entries within " << m_oracleRange << " m\n";
+    }
+    std::cout << "HELLO transmissions: " << helloTx << "\n";
+    std::cout << "HELLOs suppressed by data: " << helloSuppressed << "\n";
+    std::cout << "Positions piggybacked on data: " << piggybackTx << " sent, " << piggybackRx << " overheard\n";
+    std::cout << "Control bytes: " << helloBytes << "\n";
+    if (m_numNodes > 0 && m_simulationTime > 0) {
+        std::cout << "Control bytes per node per second: " << helloBytes / m_simulationTime / m_numNodes << "\n";
+    }
+    if (beaconSlot.IsStrictlyPositive()) {
+        GpsrBeaconScheduler *beacons = SimulationSingleton<GpsrBeaconScheduler>::Get();
+        std::cout << "Beacon calendar: " << beaconSlot.GetMilliSeconds() << " ms slots, "
+                  << beacons->GetSlotEventCount() << " slot events for "
+                  << beacons->GetDispatchCount() << " beacons\n";
+    }
+    if (m_simulationTime > 0) {
+        std::cout << "Simulator events per simulated second: " << Simulator::GetEventCount() / m_simulationTime << "\n";
+        std::cout << "Wall time per simulated second: " << 1000.0 * m_wallTime / m_simulationTime << " ms\n";
+    }
+}
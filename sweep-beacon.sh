@@ -0,0 +1,17 @@
+#!/bin/bash
+# Runs large grids with a HELLO timer per node and with the shared beacon
+# calendar, and prints the simulator event count and wall time per
+# simulated second of every run.
+#
+# Usage: ./sweep-beacon.sh [path/to/tdde35-runner] [extra runner arguments]
+
+RUNNER=${1:-./build/tdde35-runner}
+shift
+
+for nodes in 1000 10000; do
+    for slot in 0 0.001; do
+        echo "=== nodes=${nodes} beaconSlot=${slot} ==="
+        "$RUNNER" --nodes="$nodes" --time=20 --beaconSlot="$slot" "$@" \
+            | grep -E "HELLO transmissions|Beacon calendar|Simulator events|Wall time"
+    done
+done
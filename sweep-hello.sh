@@ -0,0 +1,18 @@
+#!/bin/bash
+# Sweeps the GPSR HELLO interval in the random waypoint scenario, with and
+# without neighbor position prediction, and prints the delivery ratio and
+# control overhead of every run.
+#
+# Usage: ./sweep-hello.sh [path/to/tdde35-runner] [extra runner arguments]
+
+RUNNER=${1:-./build/tdde35-runner}
+shift
+
+for prediction in false true; do
+    for interval in 0.5 1 2 4 8; do
+        echo "=== helloInterval=${interval} prediction=${prediction} ==="
+        "$RUNNER" --nodes=50 --time=60 --topology=Random --mobility=RandomWaypoint --speed=10 \
+                  --helloInterval="$interval" --prediction="$prediction" "$@" \
+            | grep -E "Overall Packet Delivery Ratio|Control bytes per node per second"
+    done
+done
@@ -0,0 +1,18 @@
+#!/bin/bash
+# Runs many crossing flows on the grid with and without congestion-aware
+# load spreading, and prints the aggregate throughput and delay tail of
+# every run.
+#
+# Usage: ./sweep-spread.sh [path/to/tdde35-runner] [extra runner arguments]
+
+RUNNER=${1:-./build/tdde35-runner}
+shift
+
+for flows in 2 4 8; do
+    for tolerance in 0 0.3; do
+        echo "=== flows=${flows} loadTolerance=${tolerance} ==="
+        "$RUNNER" --nodes=25 --time=60 --flows="$flows" --flowInterval=0.05 \
+                  --helloLoad=true --loadTolerance="$tolerance" "$@" \
+            | grep -E "Overall Packet Delivery Ratio|Aggregate Throughput|Delay percentiles"
+    done
+done
@@ -0,0 +1,99 @@
+// Randomized differential test of GpsrGreedyKernel::ArgMin against the
+// scalar loop GpsrPtable::BestNeighbor runs on the map backend. Every
+// instruction set must return the same index and a bit-identical distance.
+
+#include "gpsr/gpsr-greedy-kernel.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using ns3::GpsrGreedyKernel;
+
+namespace {
+
+// CalculateDistance(neighbor, dst) is (dst - neighbor).GetLength(), and the
+// loop keeps the first neighbor unless a later one is strictly closer
+std::size_t
+ReferenceArgMin(const std::vector<double> &xs, const std::vector<double> &ys,
+                double dstX, double dstY, double dstZ, double &distance)
+{
+  std::size_t best = 0;
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    double dx = dstX - xs[i];
+    double dy = dstY - ys[i];
+    double dz = dstZ - 0.0;
+    double d = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (i == 0 || distance > d) {
+      best = i;
+      distance = d;
+    }
+  }
+  return best;
+}
+
+bool
+SameBits(double a, double b)
+{
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+const char *
+IsaName(GpsrGreedyKernel::Isa isa)
+{
+  return isa == GpsrGreedyKernel::AVX2 ? "AVX2" : isa == GpsrGreedyKernel::SSE2 ? "SSE2" : "scalar";
+}
+
+} // namespace
+
+int
+main()
+{
+  const GpsrGreedyKernel::Isa isas[] = {GpsrGreedyKernel::SCALAR, GpsrGreedyKernel::SSE2, GpsrGreedyKernel::AVX2};
+  const uint32_t cases = 100000;
+
+  std::mt19937_64 random(20250417);
+  std::uniform_real_distribution<double> field(-1000.0, 1000.0);
+  std::uniform_int_distribution<int> grid(-4, 4);
+  std::uniform_int_distribution<std::size_t> size(1, 70);
+
+  uint64_t checked = 0;
+  uint64_t failures = 0;
+  for (uint32_t c = 0; c < cases; ++c) {
+    // Every other case puts neighbors and destination on a small integer
+    // grid, so many neighbors are exactly as far away and ties decide
+    bool ties = c % 2 == 1;
+    std::size_t n = size(random);
+    std::vector<double> xs(n);
+    std::vector<double> ys(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      xs[i] = ties ? grid(random) * 10.0 : field(random);
+      ys[i] = ties ? grid(random) * 10.0 : field(random);
+    }
+    double dstX = ties ? grid(random) * 10.0 : field(random);
+    double dstY = ties ? grid(random) * 10.0 : field(random);
+    double dstZ = c % 5 == 0 ? field(random) / 100.0 : 0.0;
+
+    double expectedDistance = 0;
+    std::size_t expected = ReferenceArgMin(xs, ys, dstX, dstY, dstZ, expectedDistance);
+
+    for (GpsrGreedyKernel::Isa isa : isas) {
+      double distance = 0;
+      std::size_t index = GpsrGreedyKernel::ArgMin(isa, xs.data(), ys.data(), n, dstX, dstY, dstZ, distance);
+      ++checked;
+      if (index != expected || !SameBits(distance, expectedDistance)) {
+        if (++failures <= 10) {
+          std::cerr << IsaName(isa) << " case " << c << " (n = " << n << "): index " << index
+                    << " distance " << distance << ", expected " << expected
+                    << " distance " << expectedDistance << std::endl;
+        }
+      }
+    }
+  }
+
+  std::cout << checked << " checks, best instruction set " << IsaName(GpsrGreedyKernel::GetIsa())
+            << ", " << failures << " mismatches" << std::endl;
+  return failures == 0 ? 0 : 1;
+}